@@ -0,0 +1,103 @@
+#include "benchmark.h"
+
+#include "sound/adpcm.h"
+
+#include <cstring>
+
+// Blocks encoded per iteration (~1 s of audio)
+constexpr const size_t BLOCK_COUNT = BENCHMARK_SAMPLE_RATE / ADPCM_SAMPLES_PER_BLOCK;
+
+static void append_bytes(std::vector<int8_t> &buffer, const void *data, size_t size)
+{
+    const size_t offset = buffer.size();
+    buffer.resize(offset + size);
+    std::memcpy(buffer.data() + offset, data, size);
+}
+
+template <typename T> static void append_value(std::vector<int8_t> &buffer, T value)
+{
+    append_bytes(buffer, &value, sizeof(value));
+}
+
+static std::vector<int8_t> make_adpcm_wav(const std::vector<uint8_t> &blocks, const AudioFormat &format,
+                                          size_t block_size, size_t num_samples)
+{
+    std::vector<int8_t> buffer;
+    append_bytes(buffer, "RIFF", 4);
+    append_value<uint32_t>(buffer, 52 + blocks.size());
+    append_bytes(buffer, "WAVEfmt ", 8);
+    append_value<uint32_t>(buffer, 20);
+    append_value<uint16_t>(buffer, 0x0011);
+    append_value<uint16_t>(buffer, format.num_channels);
+    append_value<uint32_t>(buffer, format.sample_rate);
+    append_value<uint32_t>(buffer, format.sample_rate * block_size / ADPCM_SAMPLES_PER_BLOCK);
+    append_value<uint16_t>(buffer, block_size);
+    append_value<uint16_t>(buffer, ADPCM_BITS_PER_SAMPLE);
+    append_value<uint16_t>(buffer, 2);
+    append_value<uint16_t>(buffer, ADPCM_SAMPLES_PER_BLOCK);
+    append_bytes(buffer, "fact", 4);
+    append_value<uint32_t>(buffer, 4);
+    append_value<uint32_t>(buffer, num_samples);
+    append_bytes(buffer, "data", 4);
+    append_value<uint32_t>(buffer, blocks.size());
+    append_bytes(buffer, blocks.data(), blocks.size());
+    return buffer;
+}
+
+static void benchmark_format(const AudioFormat &format)
+{
+    const size_t num_samples = BLOCK_COUNT * ADPCM_SAMPLES_PER_BLOCK;
+    AudioData audio(format, num_samples);
+    fill_benchmark_audio(audio);
+
+    const size_t block_size = get_adpcm_block_size(format.num_channels, ADPCM_SAMPLES_PER_BLOCK);
+    std::vector<uint8_t> blocks(BLOCK_COUNT * block_size);
+
+    {
+        const auto result = run_benchmark(num_samples,
+                                          [&audio, &blocks, block_size]
+                                          {
+                                              AdpcmState states[ADPCM_MAX_NUM_CHANNELS];
+                                              for (size_t i = 0; i < BLOCK_COUNT; i++)
+                                              {
+                                                  const ConstAudioView block_audio = audio.view().subview(
+                                                      i * ADPCM_SAMPLES_PER_BLOCK, ADPCM_SAMPLES_PER_BLOCK);
+                                                  encode_adpcm_block(block_audio, states, &blocks[i * block_size]);
+                                              }
+                                          });
+        report_benchmark("adpcm_encode", format, result);
+    }
+
+    {
+        AudioData decoded(format, num_samples);
+        const auto result = run_benchmark(num_samples,
+                                          [&decoded, &blocks, block_size]
+                                          {
+                                              for (size_t i = 0; i < BLOCK_COUNT; i++)
+                                              {
+                                                  const AudioView block_audio = decoded.view().subview(
+                                                      i * ADPCM_SAMPLES_PER_BLOCK, ADPCM_SAMPLES_PER_BLOCK);
+                                                  decode_adpcm_block(&blocks[i * block_size], block_size, block_audio);
+                                              }
+                                          });
+        report_benchmark("adpcm_decode", format, result);
+    }
+
+    {
+        const std::vector<int8_t> wav = make_adpcm_wav(blocks, format, block_size, num_samples);
+        const auto result = run_benchmark(num_samples, [&wav] { AudioData::load_wav(wav); });
+        report_benchmark("adpcm_load_wav", format, result);
+    }
+}
+
+void run_adpcm_benchmarks()
+{
+    for (uint32_t num_channels = 1; num_channels <= 3; num_channels++)
+    {
+        benchmark_format(AudioFormat{
+            .num_channels = num_channels,
+            .bits_per_sample = 16,
+            .sample_rate = BENCHMARK_SAMPLE_RATE,
+        });
+    }
+}
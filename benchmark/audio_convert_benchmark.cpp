@@ -0,0 +1,98 @@
+#include "benchmark.h"
+
+#include "sound/audio_convert.h"
+
+// Microphone layout of the INMP441 capture: 32-bit I2S stereo narrowed to 16 bits
+constexpr const uint32_t MICROPHONE_CHANNELS = 2;
+constexpr const int MICROPHONE_SHIFT = 14;
+
+static const AudioFormat MICROPHONE_FORMAT = {
+    .num_channels = MICROPHONE_CHANNELS,
+    .bits_per_sample = 16,
+    .sample_rate = BENCHMARK_SAMPLE_RATE,
+};
+
+// AFE layout: two microphone channels and a reference channel
+static const AudioFormat AFE_FORMAT = {
+    .num_channels = MICROPHONE_CHANNELS + 1,
+    .bits_per_sample = 16,
+    .sample_rate = BENCHMARK_SAMPLE_RATE,
+};
+
+static void benchmark_convert_samples(const char *name, const AudioFormat &input_format,
+                                      const AudioFormat &output_format)
+{
+    AudioData input(input_format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(input);
+    AudioData output(output_format, BENCHMARK_CHUNK_SAMPLES);
+    const auto result =
+        run_benchmark(BENCHMARK_CHUNK_SAMPLES, [&input, &output] { convert_samples(input, output); });
+    report_benchmark(name, output_format, result);
+}
+
+void run_audio_convert_benchmarks()
+{
+    std::vector<int32_t> i2s_buffer(BENCHMARK_CHUNK_SAMPLES * MICROPHONE_CHANNELS);
+    for (size_t i = 0; i < i2s_buffer.size(); i++)
+        i2s_buffer[i] = static_cast<int32_t>(i * 2654435761u);
+
+    {
+        // narrow into the microphone layout, then add the reference channel
+        AudioData audio;
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES,
+            [&audio, &i2s_buffer]
+            {
+                narrow_interleave_i32_to_i16(i2s_buffer.data(), MICROPHONE_CHANNELS, audio, MICROPHONE_SHIFT);
+                audio.add_channels(1);
+            },
+            [&audio] { audio.set_format(MICROPHONE_FORMAT, BENCHMARK_CHUNK_SAMPLES); });
+        report_benchmark("capture_two_pass", AFE_FORMAT, result);
+    }
+
+    {
+        AudioData audio(AFE_FORMAT, BENCHMARK_CHUNK_SAMPLES);
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES,
+            [&audio, &i2s_buffer]
+            { narrow_interleave_i32_to_i16(i2s_buffer.data(), MICROPHONE_CHANNELS, audio, MICROPHONE_SHIFT); });
+        report_benchmark("capture_fused", AFE_FORMAT, result);
+    }
+
+    {
+        // full precision capture into the AFE layout
+        const AudioFormat format = {
+            .num_channels = MICROPHONE_CHANNELS + 1,
+            .bits_per_sample = 32,
+            .sample_rate = BENCHMARK_SAMPLE_RATE,
+        };
+        AudioData audio(format, BENCHMARK_CHUNK_SAMPLES);
+        const auto result =
+            run_benchmark(BENCHMARK_CHUNK_SAMPLES, [&audio, &i2s_buffer]
+                          { interleave_i32(i2s_buffer.data(), MICROPHONE_CHANNELS, audio); });
+        report_benchmark("capture_i32", format, result);
+    }
+
+    const auto make_format = [](uint32_t bits_per_sample, bool floating_point = false)
+    {
+        return AudioFormat{
+            .num_channels = MICROPHONE_CHANNELS,
+            .bits_per_sample = bits_per_sample,
+            .sample_rate = BENCHMARK_SAMPLE_RATE,
+            .floating_point = floating_point,
+        };
+    };
+    const AudioFormat i16 = make_format(16);
+    const AudioFormat i24 = make_format(24);
+    const AudioFormat i32 = make_format(32);
+    const AudioFormat f32 = make_format(32, true);
+
+    benchmark_convert_samples("convert_i32_to_i16", i32, i16);
+    benchmark_convert_samples("convert_i16_to_i32", i16, i32);
+    benchmark_convert_samples("convert_i32_to_i24", i32, i24);
+    benchmark_convert_samples("convert_i24_to_i32", i24, i32);
+    benchmark_convert_samples("convert_i16_to_f32", i16, f32);
+    benchmark_convert_samples("convert_f32_to_i16", f32, i16);
+    benchmark_convert_samples("convert_i32_to_f32", i32, f32);
+    benchmark_convert_samples("convert_f32_to_i32", f32, i32);
+}
@@ -0,0 +1,214 @@
+#include "benchmark.h"
+
+#include "sound/audio_buffer.h"
+#include "sound/prompt_pack.h"
+#include "sound/wav_stream.h"
+
+#include <cstring>
+
+// Chunks joined per iteration of the join benchmark (~1 s of audio)
+constexpr const size_t JOIN_CHUNK_COUNT = 32;
+
+// Samples per read of the output task (20 ms)
+constexpr const size_t STREAM_READ_SAMPLES = 320;
+
+static void append_bytes(std::vector<int8_t> &buffer, const void *data, size_t size)
+{
+    const size_t offset = buffer.size();
+    buffer.resize(offset + size);
+    std::memcpy(buffer.data() + offset, data, size);
+}
+
+template <typename T> static void append_value(std::vector<int8_t> &buffer, T value)
+{
+    append_bytes(buffer, &value, sizeof(value));
+}
+
+static std::vector<int8_t> make_wav(const AudioData &audio)
+{
+    const AudioFormat &format = audio.get_format();
+    const uint16_t block_align = format.num_channels * format.bits_per_sample / 8;
+
+    std::vector<int8_t> buffer;
+    append_bytes(buffer, "RIFF", 4);
+    append_value<uint32_t>(buffer, 36 + audio.get_size());
+    append_bytes(buffer, "WAVEfmt ", 8);
+    append_value<uint32_t>(buffer, 16);
+    append_value<uint16_t>(buffer, 1);
+    append_value<uint16_t>(buffer, format.num_channels);
+    append_value<uint32_t>(buffer, format.sample_rate);
+    append_value<uint32_t>(buffer, format.sample_rate * block_align);
+    append_value<uint16_t>(buffer, block_align);
+    append_value<uint16_t>(buffer, format.bits_per_sample);
+    append_bytes(buffer, "data", 4);
+    append_value<uint32_t>(buffer, audio.get_size());
+    append_bytes(buffer, audio.get_data(), audio.get_size());
+    return buffer;
+}
+
+// Pack of a single resident prompt, in the layout of tools/build_prompts.py
+static std::vector<int8_t> make_prompt_pack(const AudioData &audio)
+{
+    const AudioFormat &format = audio.get_format();
+    const std::vector<int8_t> wav = make_wav(audio);
+    const uint32_t wav_offset = 20 + 32;
+    const uint32_t data_offset = wav_offset + 44;
+
+    std::vector<int8_t> buffer;
+    append_bytes(buffer, "NPRM", 4);
+    append_value<uint16_t>(buffer, PromptPack::VERSION);
+    append_value<uint16_t>(buffer, 1);
+    append_value<uint32_t>(buffer, format.sample_rate);
+    append_value<uint16_t>(buffer, format.num_channels);
+    append_value<uint16_t>(buffer, format.bits_per_sample);
+    append_value<uint32_t>(buffer, wav_offset + wav.size());
+    char name[PromptPack::MAX_NAME_SIZE] = "prompt";
+    append_bytes(buffer, name, sizeof(name));
+    append_value<uint32_t>(buffer, wav_offset);
+    append_value<uint32_t>(buffer, data_offset);
+    append_value<uint32_t>(buffer, audio.get_num_samples());
+    append_value<uint32_t>(buffer, 1);
+    append_bytes(buffer, wav.data(), wav.size());
+    return buffer;
+}
+
+static void benchmark_format(const AudioFormat &format)
+{
+    AudioData chunk(format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(chunk);
+
+    {
+        const std::vector<int8_t> wav = make_wav(chunk);
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES, [&wav] { AudioData::load_wav(wav); });
+        report_benchmark("load_wav", format, result);
+    }
+
+    if (format.bits_per_sample == 16)
+    {
+        // packs are always built in the 16-bit output format
+        const std::vector<int8_t> pack = make_prompt_pack(chunk);
+        PromptPack prompt_pack;
+        volatile size_t sink = 0;
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                          [&pack, &prompt_pack, &format, &sink]
+                                          {
+                                              MemoryReadStream stream(pack.data(), pack.size());
+                                              prompt_pack.load(stream, format);
+                                              sink = prompt_pack.find("prompt")->audio.get_num_samples();
+                                          });
+        report_benchmark("prompt_pack_load", format, result);
+    }
+
+    {
+        const std::vector<int8_t> wav = make_wav(chunk);
+        volatile size_t sink = 0;
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                          [&wav, &sink] { sink = AudioData::view_wav(wav).get_num_samples(); });
+        report_benchmark("view_wav", format, result);
+    }
+
+    {
+        // ~1 s streamed to 16-bit in reads of the output task, the producer fills in between
+        AudioData long_audio(format, 0);
+        for (size_t i = 0; i < JOIN_CHUNK_COUNT; i++)
+            long_audio.join(chunk);
+        const std::vector<int8_t> wav = make_wav(long_audio);
+
+        AudioFormat output_format = format;
+        output_format.bits_per_sample = 16;
+        output_format.floating_point = false;
+        AudioData output(output_format, STREAM_READ_SAMPLES);
+
+        std::unique_ptr<WavStream> stream;
+        const auto result = run_benchmark(
+            long_audio.get_num_samples(),
+            [&stream, &output]
+            {
+                while (stream->read(output) == STREAM_READ_SAMPLES)
+                    stream->fill();
+            },
+            [&stream, &wav, &output_format]
+            {
+                stream = std::make_unique<WavStream>(std::make_unique<MemoryReadStream>(wav.data(), wav.size()),
+                                                     output_format);
+                stream->open();
+            });
+        report_benchmark("wav_stream", format, result);
+    }
+
+    {
+        AudioData audio;
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES, [&audio] { audio.add_channels(1); },
+            [&audio, &format] { audio.set_format(format, BENCHMARK_CHUNK_SAMPLES); });
+        report_benchmark("add_channels", format, result);
+    }
+
+    {
+        AudioData audio = chunk;
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES, [&audio] { audio.adjust_volume(0.5f); },
+            [&audio, &chunk] { std::memcpy(audio.get_data(), chunk.get_data(), chunk.get_size()); });
+        report_benchmark("adjust_volume", format, result);
+    }
+
+    {
+        AudioData audio;
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES * JOIN_CHUNK_COUNT,
+            [&audio, &chunk]
+            {
+                for (size_t i = 0; i < JOIN_CHUNK_COUNT; i++)
+                    audio.join(chunk);
+            },
+            [&audio, &format] { audio = AudioData(format, 0); });
+        report_benchmark("join", format, result);
+    }
+
+    {
+        volatile int32_t sink = 0;
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                          [&chunk, &sink]
+                                          {
+                                              int32_t sum = 0;
+                                              for (uint32_t i = 0; i < chunk.get_num_samples(); i++)
+                                                  sum += chunk.get_value(i, 0);
+                                              sink = sum;
+                                          });
+        report_benchmark("get_value", format, result);
+    }
+
+    {
+        AudioData audio = chunk;
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                          [&audio]
+                                          {
+                                              for (uint32_t i = 0; i < audio.get_num_samples(); i++)
+                                                  audio.set_value(i, 0, static_cast<int32_t>(i));
+                                          });
+        report_benchmark("set_value", format, result);
+    }
+
+    {
+        volatile int32_t sink = 0;
+        const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                          [&chunk, &sink]
+                                          {
+                                              int32_t sum = 0;
+                                              visit_typed(chunk.view(),
+                                                          [&sum](auto typed_audio)
+                                                          {
+                                                              for (size_t i = 0; i < typed_audio.get_num_samples(); i++)
+                                                                  sum += typed_audio.at(i, 0);
+                                                          });
+                                              sink = sum;
+                                          });
+        report_benchmark("typed_get", format, result);
+    }
+}
+
+void run_audio_data_benchmarks()
+{
+    for (const AudioFormat &format : get_benchmark_formats())
+        benchmark_format(format);
+}
@@ -0,0 +1,59 @@
+#include "benchmark.h"
+
+#include "sound/audio_gain.h"
+
+#include <cstring>
+
+// Reference: the float multiply and truncating cast adjust_volume used before
+template <typename ItemType> static void float_volume_impl(AudioView audio, float factor)
+{
+    auto data = audio.get_data_typed<ItemType>();
+    const size_t size = audio.get_num_samples() * audio.get_num_channels();
+    for (size_t i = 0; i < size; i++)
+        data[i] = static_cast<ItemType>(data[i] * factor);
+}
+
+static void float_volume(AudioView audio, float factor)
+{
+    switch (audio.get_bits_per_sample())
+    {
+    case 8:
+        float_volume_impl<int8_t>(audio, factor);
+        break;
+    case 16:
+        float_volume_impl<int16_t>(audio, factor);
+        break;
+    case 32:
+        float_volume_impl<int32_t>(audio, factor);
+        break;
+    }
+}
+
+static void benchmark_gain(const char *name, const AudioData &chunk, std::function<void(AudioView)> proc)
+{
+    AudioData audio = chunk;
+    const auto result = run_benchmark(
+        BENCHMARK_CHUNK_SAMPLES, [&audio, &proc] { proc(audio); },
+        [&audio, &chunk] { std::memcpy(audio.get_data(), chunk.get_data(), chunk.get_size()); });
+    report_benchmark(name, chunk.get_format(), result);
+}
+
+void run_audio_gain_benchmarks()
+{
+    const Gain attenuation = make_gain(0.05f);
+    const Gain boost = make_gain(4.0f);
+
+    for (const AudioFormat &format : get_benchmark_formats())
+    {
+        AudioData chunk(format, BENCHMARK_CHUNK_SAMPLES);
+        fill_benchmark_audio(chunk);
+
+        // the reference never supported packed 24 bits
+        if (format.bits_per_sample != 24)
+            benchmark_gain("float_volume", chunk, [](AudioView audio) { float_volume(audio, 0.05f); });
+        benchmark_gain("apply_gain", chunk, [attenuation](AudioView audio) { apply_gain(audio, attenuation); });
+        benchmark_gain("apply_gain_boost", chunk, [boost](AudioView audio) { apply_gain(audio, boost); });
+        benchmark_gain("apply_gain_ramp", chunk,
+                       [attenuation](AudioView audio) { apply_gain_ramp(audio, GAIN_UNITY, attenuation); });
+    }
+}
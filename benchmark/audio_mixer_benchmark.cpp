@@ -0,0 +1,69 @@
+#include "benchmark.h"
+
+#include "sound/audio_mixer.h"
+
+#include <cstring>
+#include <string>
+
+// Samples per chunk of the output task (20 ms at 16 kHz)
+constexpr const size_t MIXER_CHUNK_SAMPLES = 320;
+
+// Plays the same audio over and over, the voice never ends
+class LoopSource : public AudioMixer::ISource
+{
+public:
+    explicit LoopSource(const AudioData &audio) : m_audio(audio) {}
+
+    size_t read(AudioView audio) override
+    {
+        std::memcpy(audio.get_data(), m_audio.get_data(), audio.get_size());
+        return audio.get_num_samples();
+    }
+
+    void on_finished() override {}
+
+private:
+    const AudioData &m_audio;
+};
+
+static void benchmark_mixer(const char *name, const AudioData &source_audio, size_t num_voices,
+                            AudioMixer::Priority top_priority, bool change_volume = false)
+{
+    const AudioFormat &format = source_audio.get_format();
+    AudioMixer mixer(format, MIXER_CHUNK_SAMPLES);
+    for (size_t i = 0; i < num_voices; i++)
+    {
+        const AudioMixer::Priority priority = i == 0 ? top_priority : AudioMixer::Priority::MEDIA;
+        mixer.add_voice(std::make_shared<LoopSource>(source_audio), make_gain(0.5f), priority);
+    }
+
+    AudioData output(format, MIXER_CHUNK_SAMPLES);
+    // a new master volume every chunk keeps every voice ramping
+    const Gain volumes[] = {make_volume_gain(80), make_volume_gain(40)};
+    size_t chunk = 0;
+    const auto result = run_benchmark(MIXER_CHUNK_SAMPLES,
+                                      [&]
+                                      {
+                                          if (change_volume)
+                                              mixer.set_master_gain(volumes[chunk++ % 2]);
+                                          mixer.mix(output);
+                                      });
+    report_benchmark((name + std::to_string(num_voices)).c_str(), format, result);
+}
+
+void run_audio_mixer_benchmarks()
+{
+    // the mixer runs in the native output format only
+    const AudioFormat format = {
+        .num_channels = 2,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    AudioData source_audio(format, MIXER_CHUNK_SAMPLES);
+    fill_benchmark_audio(source_audio);
+
+    for (size_t num_voices = 0; num_voices <= AudioMixer::MAX_NUM_VOICES; num_voices++)
+        benchmark_mixer("mix_voices_", source_audio, num_voices, AudioMixer::Priority::MEDIA);
+    benchmark_mixer("mix_ducked_", source_audio, AudioMixer::MAX_NUM_VOICES, AudioMixer::Priority::FEEDBACK);
+    benchmark_mixer("mix_volume_", source_audio, AudioMixer::MAX_NUM_VOICES, AudioMixer::Priority::MEDIA, true);
+}
@@ -0,0 +1,41 @@
+#include "benchmark.h"
+
+#include "sound/audio_recorder.h"
+
+// Chunks appended per iteration (~1 s of audio)
+constexpr const size_t APPEND_CHUNK_COUNT = 32;
+
+// Recorder capacity, smaller than a single iteration so it wraps
+constexpr const size_t RECORDER_MAX_SAMPLES = BENCHMARK_SAMPLE_RATE / 2;
+
+static void benchmark_policy(const char *name, const AudioFormat &format, AudioRecorder::FullPolicy policy,
+                             AudioRecorder::Encoding encoding = AudioRecorder::Encoding::PCM)
+{
+    AudioData chunk(format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(chunk);
+
+    AudioRecorder recorder(format, RECORDER_MAX_SAMPLES, policy, encoding);
+    const auto result = run_benchmark(
+        BENCHMARK_CHUNK_SAMPLES * APPEND_CHUNK_COUNT,
+        [&recorder, &chunk]
+        {
+            for (size_t i = 0; i < APPEND_CHUNK_COUNT; i++)
+                recorder.append(chunk);
+        },
+        [&recorder] { recorder.start(); });
+    report_benchmark(name, format, result);
+}
+
+void run_audio_recorder_benchmarks()
+{
+    for (const AudioFormat &format : get_benchmark_formats())
+    {
+        benchmark_policy("recorder_overwrite", format, AudioRecorder::FullPolicy::OVERWRITE_OLDEST);
+        benchmark_policy("recorder_stop", format, AudioRecorder::FullPolicy::STOP);
+        if (format.bits_per_sample == 16)
+        {
+            benchmark_policy("recorder_adpcm", format, AudioRecorder::FullPolicy::OVERWRITE_OLDEST,
+                             AudioRecorder::Encoding::ADPCM);
+        }
+    }
+}
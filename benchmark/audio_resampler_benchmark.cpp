@@ -0,0 +1,49 @@
+#include "benchmark.h"
+
+#include "sound/audio_resampler.h"
+
+// Length of the converted asset (1 s at the input rate)
+constexpr const double ASSET_SECONDS = 1.0;
+
+static void benchmark_conversion(const char *name, const AudioFormat &input_format, const AudioFormat &output_format)
+{
+    AudioData input(input_format, static_cast<size_t>(input_format.sample_rate * ASSET_SECONDS));
+    fill_benchmark_audio(input);
+
+    const auto result = run_benchmark(input.get_num_samples(), [&input, &output_format]
+                                      { convert_audio(input, output_format); });
+    report_benchmark(name, input_format, result);
+}
+
+void run_audio_resampler_benchmarks()
+{
+    const AudioFormat output_format = {
+        .num_channels = 2,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+
+    for (uint32_t sample_rate : {8000, 22050, 44100, 48000})
+    {
+        const AudioFormat input_format = {
+            .num_channels = 2,
+            .bits_per_sample = 16,
+            .sample_rate = sample_rate,
+        };
+        benchmark_conversion("resample", input_format, output_format);
+    }
+
+    const AudioFormat mono_format = {
+        .num_channels = 1,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    benchmark_conversion("upmix", mono_format, output_format);
+
+    const AudioFormat wide_format = {
+        .num_channels = 2,
+        .bits_per_sample = 32,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    benchmark_conversion("narrow", wide_format, output_format);
+}
@@ -0,0 +1,121 @@
+#include "benchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+constexpr const auto MIN_BENCHMARK_DURATION = std::chrono::milliseconds(200);
+constexpr const size_t MIN_BENCHMARK_ITERATIONS = 16;
+
+static std::atomic<size_t> allocated_bytes = 0;
+static std::atomic<size_t> allocation_count = 0;
+
+void *operator new(size_t size)
+{
+    allocated_bytes += size;
+    allocation_count++;
+    if (void *ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+BenchmarkResult run_benchmark(size_t samples_per_iteration, std::function<void()> proc, std::function<void()> setup)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration elapsed = {};
+    size_t iterations = 0;
+    size_t bytes = 0;
+    size_t count = 0;
+
+    while (elapsed < MIN_BENCHMARK_DURATION || iterations < MIN_BENCHMARK_ITERATIONS)
+    {
+        if (setup != nullptr)
+            setup();
+
+        const size_t bytes_before = allocated_bytes;
+        const size_t count_before = allocation_count;
+        const auto start = Clock::now();
+        proc();
+        elapsed += Clock::now() - start;
+        bytes += allocated_bytes - bytes_before;
+        count += allocation_count - count_before;
+        iterations++;
+    }
+
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+    return BenchmarkResult{
+        .ns_per_sample = ns / (static_cast<double>(iterations) * samples_per_iteration),
+        .bytes_per_iteration = static_cast<double>(bytes) / iterations,
+        .allocations_per_iteration = static_cast<double>(count) / iterations,
+    };
+}
+
+void report_benchmark(const char *name, const AudioFormat &format, const BenchmarkResult &result)
+{
+    printf("%-24s %2lu ch %2lu bit %6lu Hz %10.3f ns/sample %12.1f B/iter %8.2f allocs/iter\n", name,
+           static_cast<unsigned long>(format.num_channels), static_cast<unsigned long>(format.bits_per_sample),
+           static_cast<unsigned long>(format.sample_rate), result.ns_per_sample, result.bytes_per_iteration,
+           result.allocations_per_iteration);
+}
+
+std::vector<AudioFormat> get_benchmark_formats()
+{
+    std::vector<AudioFormat> formats;
+    for (uint32_t bits_per_sample : {8, 16, 24, 32})
+    {
+        for (uint32_t num_channels = 1; num_channels <= 3; num_channels++)
+        {
+            formats.push_back(AudioFormat{
+                .num_channels = num_channels,
+                .bits_per_sample = bits_per_sample,
+                .sample_rate = BENCHMARK_SAMPLE_RATE,
+            });
+        }
+    }
+    return formats;
+}
+
+void fill_benchmark_audio(AudioData &audio)
+{
+    const int32_t max_value = (1 << (audio.get_bits_per_sample() - 2)) - 1;
+    uint32_t state = 12345;
+    for (uint32_t i = 0; i < audio.get_num_samples(); i++)
+    {
+        for (uint32_t channel = 0; channel < audio.get_num_channels(); channel++)
+        {
+            state = state * 1103515245 + 12345;
+            audio.set_value(i, channel, static_cast<int32_t>(state >> 8) % max_value);
+        }
+    }
+}
+
+int main()
+{
+    printf("Audio benchmark: %lu samples per chunk\n", static_cast<unsigned long>(BENCHMARK_CHUNK_SAMPLES));
+    run_audio_data_benchmarks();
+    run_audio_recorder_benchmarks();
+    run_audio_gain_benchmarks();
+    run_audio_mixer_benchmarks();
+    run_audio_convert_benchmarks();
+    run_audio_resampler_benchmarks();
+    run_adpcm_benchmarks();
+    run_capture_pipeline_benchmarks();
+    run_capture_ring_benchmarks();
+    run_echo_reference_benchmarks();
+    run_jitter_buffer_benchmarks();
+    run_level_meter_benchmarks();
+    return 0;
+}
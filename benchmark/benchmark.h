@@ -0,0 +1,47 @@
+#pragma once
+
+#include "sound/audio_data.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Sample rate of the audio feed path, every benchmark runs at it
+constexpr const uint32_t BENCHMARK_SAMPLE_RATE = 16000;
+
+// Samples per chunk fed to the AFE (32 ms at 16 kHz)
+constexpr const size_t BENCHMARK_CHUNK_SAMPLES = 512;
+
+struct BenchmarkResult
+{
+    double ns_per_sample = 0;
+    double bytes_per_iteration = 0;
+    double allocations_per_iteration = 0;
+};
+
+// Runs proc until enough time is accumulated. Setup is executed before every
+// iteration and is excluded from both the time and the allocation counters.
+BenchmarkResult run_benchmark(size_t samples_per_iteration, std::function<void()> proc,
+                              std::function<void()> setup = nullptr);
+
+void report_benchmark(const char *name, const AudioFormat &format, const BenchmarkResult &result);
+
+// Formats every benchmark is run for: 1-3 channels, 8/16/32 bits
+std::vector<AudioFormat> get_benchmark_formats();
+
+// Fills audio with a deterministic, non-trivial signal
+void fill_benchmark_audio(AudioData &audio);
+
+void run_audio_data_benchmarks();
+void run_audio_recorder_benchmarks();
+void run_audio_gain_benchmarks();
+void run_audio_mixer_benchmarks();
+void run_audio_convert_benchmarks();
+void run_audio_resampler_benchmarks();
+void run_adpcm_benchmarks();
+void run_capture_pipeline_benchmarks();
+void run_capture_ring_benchmarks();
+void run_echo_reference_benchmarks();
+void run_jitter_buffer_benchmarks();
+void run_level_meter_benchmarks();
@@ -0,0 +1,57 @@
+#include "benchmark.h"
+
+#include "sound/capture_stages.h"
+
+#include <chrono>
+#include <cstdio>
+
+// The host has no portable cycle counter, nanoseconds stand in for cycles
+static uint32_t benchmark_cycle_count()
+{
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+static void run_stage_benchmark(const char *name, const AudioFormat &format, CapturePipeline::Stage &stage)
+{
+    AudioData audio(format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(audio);
+    const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES, [&stage, &audio] { stage.process(audio, 2); });
+    report_benchmark(name, format, result);
+}
+
+static void run_capture_pipeline_benchmarks(uint32_t bits_per_sample)
+{
+    // two microphones and the AFE reference, which is left alone
+    const AudioFormat format = {
+        .num_channels = 3,
+        .bits_per_sample = bits_per_sample,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+
+    DcBlockStage dc_block(BENCHMARK_SAMPLE_RATE, 10.0f);
+    run_stage_benchmark("capture_dc_block", format, dc_block);
+    HighPassStage high_pass(BENCHMARK_SAMPLE_RATE, 80.0f);
+    run_stage_benchmark("capture_high_pass", format, high_pass);
+    GainStage gain(make_gain(2.0f));
+    run_stage_benchmark("capture_gain", format, gain);
+    ChannelMapStage channel_map({1, 0, 2, 3});
+    run_stage_benchmark("capture_channel_map", format, channel_map);
+
+    CapturePipeline pipeline(2, benchmark_cycle_count);
+    pipeline.add_stage(std::make_unique<DcBlockStage>(BENCHMARK_SAMPLE_RATE, 10.0f));
+    pipeline.add_stage(std::make_unique<HighPassStage>(BENCHMARK_SAMPLE_RATE, 80.0f));
+    pipeline.add_stage(std::make_unique<GainStage>(make_gain(2.0f)));
+    AudioData audio(format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(audio);
+    const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES, [&pipeline, &audio] { pipeline.process(audio); });
+    report_benchmark("capture_pipeline", format, result);
+    printf("%s", pipeline.get_report().c_str());
+}
+
+void run_capture_pipeline_benchmarks()
+{
+    // 16-bit codec audio and the INMP441 audio before narrowing
+    run_capture_pipeline_benchmarks(16);
+    run_capture_pipeline_benchmarks(32);
+}
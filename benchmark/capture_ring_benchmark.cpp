@@ -0,0 +1,95 @@
+#include "benchmark.h"
+
+#include "sound/audio_convert.h"
+#include "sound/audio_recorder.h"
+#include "sound/capture_ring.h"
+#include "sound/echo_reference.h"
+
+// Samples per DMA buffer of the INMP441 input (10 ms)
+constexpr const size_t DMA_FRAME_SAMPLES = 160;
+constexpr const size_t RING_FRAMES = 32;
+constexpr const int SAMPLE_SHIFT = 14;
+
+void run_capture_ring_benchmarks()
+{
+    // native I2S layout of the microphone
+    const AudioFormat i2s_format = {
+        .num_channels = 2,
+        .bits_per_sample = 32,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    // microphone channels and the AFE reference channel
+    const AudioFormat feed_format = {
+        .num_channels = 3,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+
+    AudioData dma_buffer(i2s_format, DMA_FRAME_SAMPLES);
+    fill_benchmark_audio(dma_buffer);
+    AudioData feed(feed_format, DMA_FRAME_SAMPLES);
+
+    CaptureRing ring(i2s_format, DMA_FRAME_SAMPLES, RING_FRAMES);
+    int64_t time_us = 0;
+
+    {
+        // the ISR side alone
+        const auto result = run_benchmark(DMA_FRAME_SAMPLES,
+                                          [&ring, &dma_buffer, &time_us]
+                                          {
+                                              ring.push(dma_buffer.get_data(), time_us += 10000);
+                                              ring.pop();
+                                          });
+        report_benchmark("capture_ring_push", i2s_format, result);
+    }
+
+    {
+        // a DMA buffer through the ring into the feed layout
+        const auto result = run_benchmark(DMA_FRAME_SAMPLES,
+                                          [&ring, &dma_buffer, &feed, &time_us]
+                                          {
+                                              ring.push(dma_buffer.get_data(), time_us += 10000);
+                                              const CaptureRing::Frame *frame = ring.front();
+                                              narrow_interleave_i32_to_i16(frame->audio.get_data_typed<int32_t>(),
+                                                                           frame->audio.get_num_channels(), feed,
+                                                                           SAMPLE_SHIFT);
+                                              ring.pop();
+                                          });
+        report_benchmark("capture_ring_to_feed", feed_format, result);
+    }
+
+    {
+        // one iteration of the feed loop while recording, in DMA buffers that
+        // split the AFE chunk evenly: it must not touch the heap
+        constexpr const size_t FEED_FRAME_SAMPLES = BENCHMARK_CHUNK_SAMPLES / 4;
+        CaptureRing feed_ring(i2s_format, FEED_FRAME_SAMPLES, RING_FRAMES);
+        AudioData feed_chunk(feed_format, BENCHMARK_CHUNK_SAMPLES);
+        EchoReference echo_reference(BENCHMARK_SAMPLE_RATE);
+        const AudioFormat recording_format = {
+            .num_channels = 2,
+            .bits_per_sample = 16,
+            .sample_rate = BENCHMARK_SAMPLE_RATE,
+        };
+        AudioRecorder recorder(recording_format, BENCHMARK_SAMPLE_RATE * 10,
+                               AudioRecorder::FullPolicy::OVERWRITE_OLDEST, AudioRecorder::Encoding::ADPCM);
+        recorder.start();
+
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES,
+            [&]
+            {
+                for (size_t position = 0; position < BENCHMARK_CHUNK_SAMPLES; position += FEED_FRAME_SAMPLES)
+                {
+                    feed_ring.push(dma_buffer.get_data(), time_us += 8000);
+                    const CaptureRing::Frame *frame = feed_ring.front();
+                    narrow_interleave_i32_to_i16(frame->audio.get_data_typed<int32_t>(),
+                                                 frame->audio.get_num_channels(),
+                                                 feed_chunk.view().subview(position, FEED_FRAME_SAMPLES), SAMPLE_SHIFT);
+                    feed_ring.pop();
+                }
+                echo_reference.read(feed_chunk, 2, 0, EchoReference::get_sample_time(time_us, BENCHMARK_SAMPLE_RATE));
+                recorder.append(feed_chunk);
+            });
+        report_benchmark("feed_path", feed_format, result);
+    }
+}
@@ -0,0 +1,55 @@
+#include "benchmark.h"
+
+#include "sound/echo_reference.h"
+
+// Samples per chunk of the output task (20 ms)
+constexpr const size_t OUTPUT_CHUNK_SAMPLES = 320;
+
+void run_echo_reference_benchmarks()
+{
+    const AudioFormat output_format = {
+        .num_channels = 2,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    // two microphones and the reference
+    const AudioFormat capture_format = {
+        .num_channels = 3,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+
+    AudioData output(output_format, OUTPUT_CHUNK_SAMPLES);
+    fill_benchmark_audio(output);
+    AudioData capture(capture_format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(capture);
+
+    EchoReference echo_reference(BENCHMARK_SAMPLE_RATE);
+    uint32_t sample_time = 0;
+
+    {
+        const auto result = run_benchmark(OUTPUT_CHUNK_SAMPLES,
+                                          [&echo_reference, &output, &sample_time]
+                                          {
+                                              echo_reference.write(output, sample_time);
+                                              sample_time += OUTPUT_CHUNK_SAMPLES;
+                                          });
+        report_benchmark("echo_reference_write", output_format, result);
+    }
+
+    {
+        // the speaker keeps playing, so every read runs the delay estimation
+        const auto result = run_benchmark(
+            BENCHMARK_CHUNK_SAMPLES, [&echo_reference, &capture, &sample_time]
+            { echo_reference.read(capture, 2, 0, sample_time); },
+            [&echo_reference, &output, &sample_time]
+            {
+                for (size_t i = 0; i < 2; i++)
+                {
+                    echo_reference.write(output, sample_time);
+                    sample_time += OUTPUT_CHUNK_SAMPLES;
+                }
+            });
+        report_benchmark("echo_reference_read", capture_format, result);
+    }
+}
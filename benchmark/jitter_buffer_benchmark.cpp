@@ -0,0 +1,51 @@
+#include "benchmark.h"
+
+#include "sound/jitter_buffer.h"
+
+#include <memory>
+
+// Samples per read of the output task (20 ms)
+constexpr const size_t OUTPUT_CHUNK_SAMPLES = 320;
+
+void run_jitter_buffer_benchmarks()
+{
+    const AudioFormat format = {
+        .num_channels = 2,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+
+    AudioData input(format, OUTPUT_CHUNK_SAMPLES);
+    fill_benchmark_audio(input);
+    AudioData output(format, OUTPUT_CHUNK_SAMPLES);
+
+    JitterBuffer jitter_buffer(format);
+
+    {
+        // the download keeps up, every read is a plain copy out of the ring
+        const auto result = run_benchmark(OUTPUT_CHUNK_SAMPLES,
+                                          [&jitter_buffer, &input, &output]
+                                          {
+                                              jitter_buffer.write(input);
+                                              jitter_buffer.read(output);
+                                          });
+        report_benchmark("jitter_buffer", format, result);
+    }
+
+    {
+        // every read runs dry half way and conceals the rest of the chunk
+        std::unique_ptr<JitterBuffer> underrun_buffer;
+        const auto result = run_benchmark(
+            OUTPUT_CHUNK_SAMPLES, [&underrun_buffer, &output] { underrun_buffer->read(output); },
+            [&underrun_buffer, &input, &output, &format]
+            {
+                underrun_buffer = std::make_unique<JitterBuffer>(format);
+                while (underrun_buffer->get_num_buffered_samples() < underrun_buffer->get_target_samples())
+                    underrun_buffer->write(input);
+                underrun_buffer->write(input.view().subview(0, OUTPUT_CHUNK_SAMPLES / 2));
+                while (underrun_buffer->get_num_buffered_samples() >= OUTPUT_CHUNK_SAMPLES)
+                    underrun_buffer->read(output);
+            });
+        report_benchmark("jitter_buffer_underrun", format, result);
+    }
+}
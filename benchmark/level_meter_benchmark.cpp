@@ -0,0 +1,28 @@
+#include "benchmark.h"
+
+#include "sound/level_meter.h"
+
+void run_level_meter_benchmarks()
+{
+    // two microphones and the AFE reference, which is not measured
+    const AudioFormat format = {
+        .num_channels = 3,
+        .bits_per_sample = 16,
+        .sample_rate = BENCHMARK_SAMPLE_RATE,
+    };
+    AudioData audio(format, BENCHMARK_CHUNK_SAMPLES);
+    fill_benchmark_audio(audio);
+
+    LevelMeter level_meter(2, 50, 64);
+    LevelMeter::Level level;
+    // the chart timer keeps up, so no level is dropped
+    const auto result = run_benchmark(BENCHMARK_CHUNK_SAMPLES,
+                                      [&level_meter, &audio, &level]
+                                      {
+                                          level_meter.write(audio);
+                                          while (level_meter.read(level))
+                                          {
+                                          }
+                                      });
+    report_benchmark("level_meter", format, result);
+}
@@ -1,17 +1,23 @@
 #include "board/board.h"
 
+#include "system/allocation_tracker.h"
+#include "system/capture_health.h"
 #include "system/event_loop.h"
+#include "system/latency_probes.h"
 #include "system/resource_manager.h"
 #include "system/task.h"
 
 #include "hal/audio_input.h"
 #include "hal/audio_output.h"
+#include "hal/capture_conditioning.h"
 
 #include "WiFiHelper.h"
+#include "network/http_audio_stream.h"
 #include "network/mqtt_manager.h"
 #include "sound/speech_recognition.h"
 #include "gui/gui_box.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "bsp/esp-bsp.h"
 
 #include "hal/display.h"
@@ -19,22 +25,33 @@
 #include "secrets.h"
 #include "nossat_err.h"
 
+#include <cstdlib>
 #include <thread>
 #include <memory>
+#include <string>
 
 static const char *DEVICE_NAME = "nossat_box_lite";
 static const char *TAG = "board";
 
+const constexpr int VOLUME_STEP = 10;
+// Iterations of the feed loop that may still allocate, a few seconds of audio
+const constexpr size_t FEED_WARMUP_ITERATIONS = 100;
+const constexpr uint32_t CAPTURE_HEALTH_PUBLISH_MS = 60 * 1000;
+const constexpr uint32_t VOLUME_DISPLAY_MS = 1500;
+
 auto event_loop = std::make_shared<EventLoop>();
-ResourceManager resource_manager;
+ResourceManager resource_manager(AudioOutput::AUDIO_FORMAT);
 
-button_handle_t button = nullptr;
+button_handle_t buttons[BSP_BUTTON_NUM] = {};
 int btn_num = 0;
+uint32_t volume_display_id = 0;
 
 std::shared_ptr<Display> display;
 std::shared_ptr<Gui> gui;
 std::shared_ptr<AudioInput> audio_input;
 std::shared_ptr<AudioOutput> audio_output;
+// Conditions the microphone audio of the feed task
+std::unique_ptr<CapturePipeline> capture_pipeline;
 
 WiFiHelper
     wifi_helper(DEVICE_NAME, []() { ESP_LOGI(TAG, "WiFI Connected"); }, []() { ESP_LOGI(TAG, "WiFI Disconnected"); });
@@ -46,36 +63,94 @@ class SpeechRecognitionObserver : public SpeechRecognition::IObserver
 public:
     void on_command_not_detected() override
     {
+        m_message_id++;
         gui->show_message("Timeout");
         display->enable_backlight();
-        audio_output->play(resource_manager.not_recognized_wav);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        gui->hide_message();
-        display->enable_backlight(false);
+        LatencyProbes::instance().mark(LatencyProbes::Path::NOT_RECOGNIZED, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.open_stream(resource_manager.NOT_RECOGNIZED_PROMPT),
+                                 [this](bool) { hide_message_later(); });
     }
 
     void on_waiting_for_command() override
     {
+        m_message_id++;
         gui->show_message("Say command", true);
         display->enable_backlight();
-        audio_output->play(resource_manager.wake_wav);
+        LatencyProbes::instance().mark(LatencyProbes::Path::WAKE, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.wake_wav);
     }
 
     void on_command_handling_started(const char *message) override
     {
+        m_message_id++;
         gui->show_message(message);
         display->enable_backlight();
     }
 
     void on_command_handling_finished() override
     {
-        audio_output->play(resource_manager.recognized_wav);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        gui->hide_message();
-        display->enable_backlight(false);
+        LatencyProbes::instance().mark(LatencyProbes::Path::COMMAND, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.open_stream(resource_manager.RECOGNIZED_PROMPT),
+                                 [this](bool) { hide_message_later(); });
+    }
+
+private:
+    // Keeps the message for a second after the prompt without blocking the
+    // event loop, unless a newer message has been shown meanwhile
+    void hide_message_later()
+    {
+        const uint32_t message_id = m_message_id;
+        event_loop->post_delayed(
+            [this, message_id]()
+            {
+                if (message_id != m_message_id)
+                    return;
+                gui->hide_message();
+                display->enable_backlight(false);
+            },
+            1000);
     }
+
+private:
+    // all handlers run on the event loop
+    uint32_t m_message_id = 0;
 };
 
+// Runs on the event loop
+void set_volume(int percent)
+{
+    audio_output->set_volume(percent);
+    const int volume = audio_output->get_volume();
+    ESP_LOGI(TAG, "Volume %d %%", volume);
+
+    gui->show_volume(volume);
+    display->enable_backlight();
+    const uint32_t display_id = ++volume_display_id;
+    event_loop->post_delayed(
+        [display_id]()
+        {
+            if (display_id != volume_display_id)
+                return;
+            gui->hide_volume();
+            if (!gui->is_message_visible())
+                display->enable_backlight(false);
+        },
+        VOLUME_DISPLAY_MS);
+
+    if (mqtt_manager)
+        mqtt_manager->publish("volume", std::to_string(volume));
+}
+
+void on_volume_down(void *button_handle, void *user_data)
+{
+    event_loop->post([]() { set_volume(audio_output->get_volume() - VOLUME_STEP); });
+}
+
+void on_volume_up(void *button_handle, void *user_data)
+{
+    event_loop->post([]() { set_volume(audio_output->get_volume() + VOLUME_STEP); });
+}
+
 void add_command(std::vector<const char *> commands)
 {
     ESP_TRUE_CHECK(commands.size() > 0);
@@ -117,18 +192,34 @@ void add_commands()
 void audio_feed_task()
 {
     const size_t audio_chunksize = speech_recognition->get_feed_chunksize();
-    const AudioFormat &audio_format = audio_input->get_audio_format();
+    // microphone channels followed by the AFE reference channel
+    const AudioFormat &audio_format = SpeechRecognition::AUDIO_FORMAT;
+    const uint32_t reference_channel = audio_input->get_audio_format().num_channels;
+    const auto echo_reference = audio_output->get_echo_reference();
 
     ESP_LOGI(TAG, "Run audio feed task: num_channels %lu, bits_per_sample %lu, sample_rate %lu",
              audio_format.num_channels, audio_format.bits_per_sample, audio_format.sample_rate);
 
-    AudioData audio;
+    // the only buffer of the loop, every stage works in place or copies out of it
+    AudioData audio(audio_format, audio_chunksize);
+    AllocationTracker allocation_tracker(FEED_WARMUP_ITERATIONS);
+    CaptureHealth &capture_health = CaptureHealth::instance();
     while (true)
     {
-        audio.set_format(audio_format, audio_chunksize);
-        audio_input->capture_audio(audio);
-        audio.add_channels(SpeechRecognition::REFERENCE_CHANNEL_COUNT);
+        const int64_t read_start_us = esp_timer_get_time();
+        const int64_t capture_time_us = audio_input->capture_audio(audio);
+        const int64_t read_end_us = esp_timer_get_time();
+        capture_health.record_read(read_end_us - read_start_us, capture_time_us);
+
+        capture_pipeline->process(audio);
+        const uint32_t sample_time = EchoReference::get_sample_time(capture_time_us, audio_format.sample_rate);
+        echo_reference->read(audio, reference_channel, 0, sample_time);
+
+        const int64_t feed_start_us = esp_timer_get_time();
         speech_recognition->feed(audio);
+        capture_health.record_feed(esp_timer_get_time() - feed_start_us);
+        capture_health.end_iteration(audio_input->get_num_overflows(), audio_input->get_num_dropped_samples());
+        allocation_tracker.end_iteration();
     }
 }
 
@@ -149,6 +240,17 @@ void initialize_speech_recognition()
     create_task(detect_task, "Detect Task", 8 * 1024, 5, 0);
 }
 
+// Publishes the capture health of the last interval on "<device>/capture/health" and restarts it. The report
+// waits for the feed task, so it is taken on its own task rather than blocking the event loop.
+void capture_health_task()
+{
+    while (true)
+    {
+        vTaskDelay(CAPTURE_HEALTH_PUBLISH_MS / portTICK_PERIOD_MS);
+        mqtt_manager->publish("capture/health", CaptureHealth::instance().take_report());
+    }
+}
+
 void start()
 {
     ESP_LOGI(TAG, "******* Initialize Events *******");
@@ -164,10 +266,13 @@ void start()
 
     ESP_LOGI(TAG, "******* Initialize Audio *******");
     audio_input = std::make_shared<AudioInput>();
-    audio_output = std::make_shared<AudioOutput>();
+    audio_output = std::make_shared<AudioOutput>(event_loop);
+    capture_pipeline = create_capture_pipeline(audio_input->get_audio_format());
 
     ESP_LOGI(TAG, "******* Initialize Controls *******");
-    ESP_ERROR_CHECK(bsp_iot_button_create(&button, &btn_num, BSP_BUTTON_NUM));
+    ESP_ERROR_CHECK(bsp_iot_button_create(buttons, &btn_num, BSP_BUTTON_NUM));
+    ESP_ERROR_CHECK(iot_button_register_cb(buttons[BSP_BUTTON_PREV], BUTTON_SINGLE_CLICK, on_volume_down, nullptr));
+    ESP_ERROR_CHECK(iot_button_register_cb(buttons[BSP_BUTTON_NEXT], BUTTON_SINGLE_CLICK, on_volume_up, nullptr));
 
     ESP_LOGI(TAG, "******* Initialize Networking *******");
     ESP_LOGI(TAG, "Connect to WiFi");
@@ -175,6 +280,39 @@ void start()
 
     ESP_LOGI(TAG, "Connect to MQTT");
     mqtt_manager = std::make_unique<MqttManager>(DEVICE_NAME);
+    // a message to "<device>/latency/get" is answered with the response time report on "<device>/latency"
+    mqtt_manager->subscribe("latency/get",
+                            [](const std::string &)
+                            { mqtt_manager->publish("latency", LatencyProbes::instance().get_report()); });
+    // "<device>/capture/get" is answered with the cycle cost of every capture stage and the capture health since
+    // the last periodic report on "<device>/capture"
+    mqtt_manager->subscribe("capture/get",
+                            [](const std::string &)
+                            {
+                                mqtt_manager->publish("capture", capture_pipeline->get_report() +
+                                                                     CaptureHealth::instance().get_report());
+                            });
+    // a WAV URL sent to "<device>/play", e.g. a Home Assistant TTS response, is played while it downloads
+    mqtt_manager->subscribe("play",
+                            [](const std::string &url)
+                            {
+                                auto stream = start_http_audio_stream(url, AudioOutput::AUDIO_FORMAT);
+                                // a media stream ducks under the chimes and prompts
+                                auto play = [stream]()
+                                { audio_output->play_async(stream, nullptr, AudioMixer::Priority::MEDIA); };
+                                // nobody would ever read the stream, closing it ends the download
+                                if (!event_loop->post(play))
+                                    stream->close();
+                            });
+    // "<device>/volume/set" takes 0-100, the applied volume is reported on "<device>/volume"
+    mqtt_manager->subscribe("volume/set",
+                            [](const std::string &message)
+                            {
+                                const int percent = std::atoi(message.c_str());
+                                event_loop->post([percent]() { set_volume(percent); });
+                            });
+    mqtt_manager->publish("volume", std::to_string(audio_output->get_volume()));
+    create_task(capture_health_task, "Capture Health", 4 * 1024, 1, 0);
 
     ESP_LOGI(TAG, "******* Initialize Speech Recognition *******");
     initialize_speech_recognition();
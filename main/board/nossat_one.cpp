@@ -1,6 +1,9 @@
 #include "board/board.h"
 
+#include "system/allocation_tracker.h"
+#include "system/capture_health.h"
 #include "system/event_loop.h"
+#include "system/latency_probes.h"
 #include "system/interrupt_manager.h"
 #include "system/resource_manager.h"
 #include "system/task.h"
@@ -8,12 +11,16 @@
 #include "hal/led.h"
 #include "hal/audio_input.h"
 #include "hal/audio_output.h"
+#include "hal/capture_conditioning.h"
+
+#include "sound/audio_recorder.h"
 
 #if CONFIG_NOSSAT_LVGL_GUI
 #include "gui/gui_one.h"
 #endif
 
 #include "WiFiHelper.h"
+#include "network/http_audio_stream.h"
 #include "network/mqtt_manager.h"
 
 #include "gui/nossat-one/src/ui/screens.h"
@@ -23,19 +30,26 @@
 #else
 #endif
 
+#include <cstdlib>
+#include <string>
 #include <thread>
-#include <mutex>
 
 #include "bsp/esp-bsp.h"
 #include "secrets.h"
 #include "esp_sntp.h"
+#include "esp_timer.h"
 
 static const char *DEVICE_NAME = "nossat_one";
 static const char *TAG = "board";
 
+const constexpr uint32_t VOLUME_DISPLAY_MS = 1500;
+// Iterations of the feed loop that may still allocate, a few seconds of audio
+const constexpr size_t FEED_WARMUP_ITERATIONS = 100;
+const constexpr uint32_t CAPTURE_HEALTH_PUBLISH_MS = 60 * 1000;
+
 auto event_loop = std::make_shared<EventLoop>();
 auto interrupt_manager = std::make_shared<InterruptManager>(event_loop);
-ResourceManager resource_manager;
+ResourceManager resource_manager(AudioOutput::AUDIO_FORMAT);
 
 auto led = std::make_shared<Led>();
 
@@ -43,7 +57,9 @@ std::shared_ptr<Display> display;
 std::shared_ptr<Gui> gui;
 
 auto audio_input = std::make_shared<AudioInput>();
-auto audio_output = std::make_shared<AudioOutput>();
+std::shared_ptr<AudioOutput> audio_output;
+// Conditions the microphone audio of the feed task
+std::unique_ptr<CapturePipeline> capture_pipeline;
 
 WiFiHelper
     wifi_helper(DEVICE_NAME, []() { ESP_LOGI(TAG, "WiFI Connected"); }, []() { ESP_LOGI(TAG, "WiFI Disconnected"); });
@@ -54,42 +70,58 @@ extern "C"
 {
 #endif
 
-std::atomic<bool> recording = false;
-AudioData recorded_audio;
-std::mutex recorded_audio_mutex;
+std::unique_ptr<AudioRecorder> audio_recorder;
+// Plays the buffer of the recorder, it has to finish before the next recording
+std::shared_ptr<Playback> recording_playback;
 
 void action_on_start_recording(lv_event_t *e)
 {
     ESP_LOGI(TAG, "Start recording");
-    if (!recording)
+    if (!audio_recorder->is_recording())
     {
+        if (recording_playback)
         {
-            std::unique_lock<std::mutex> lock(recorded_audio_mutex);
-            recorded_audio = {};
+            recording_playback->cancel();
+            recording_playback->wait();
+            recording_playback = nullptr;
         }
+
         gui->show_recording_screen();
-        recording = true;
+        audio_recorder->start();
     }
 }
 
 void action_on_stop_recording(lv_event_t *e)
 {
     ESP_LOGI(TAG, "Stop recording");
-    if (recording)
+    if (audio_recorder->is_recording())
     {
-        // drop ending to avoid click
-        const uint32_t samples_per_250ms =
-            std::min(static_cast<size_t>(recorded_audio.get_sample_rate() / 4), recorded_audio.get_num_samples());
-        recorded_audio.resize(recorded_audio.get_num_samples() - samples_per_250ms);
+        audio_recorder->stop();
+        if (audio_recorder->get_num_dropped_samples() > 0)
+            ESP_LOGW(TAG, "Recording is full, %d samples dropped",
+                     static_cast<int>(audio_recorder->get_num_dropped_samples()));
 
-        {
-            ESP_LOGI(TAG, "Start playing");
-            std::unique_lock<std::mutex> lock(recorded_audio_mutex);
-            audio_output->play(recorded_audio);
-            ESP_LOGI(TAG, "End playing");
-        }
-        gui->show_current_page();
-        recording = false;
+        // drop ending to avoid click
+        const size_t num_recorded_samples = audio_recorder->get_num_samples();
+        const size_t samples_per_250ms =
+            std::min(static_cast<size_t>(audio_recorder->get_format().sample_rate / 4), num_recorded_samples);
+
+        // decoded while playing, the recording is never held as PCM
+        auto recorded_stream = std::make_unique<WavStream>(
+            audio_recorder->open_wav_stream(num_recorded_samples - samples_per_250ms), AudioOutput::AUDIO_FORMAT);
+        ESP_TRUE_CHECK(recorded_stream->open());
+
+        ESP_LOGI(TAG, "Start playing");
+        recording_playback = audio_output->play_async(std::move(recorded_stream),
+                                                      [](bool completed)
+                                                      {
+                                                          ESP_LOGI(TAG, "End playing");
+                                                          // cancelled by a new recording, its screen stays
+                                                          if (!completed && audio_recorder->is_recording())
+                                                              return;
+                                                          gui->show_current_page();
+                                                      },
+                                                      AudioMixer::Priority::MEDIA);
     }
 }
 
@@ -97,6 +129,31 @@ void action_on_stop_recording(lv_event_t *e)
 }
 #endif
 
+uint32_t volume_display_id = 0;
+
+// Runs on the event loop
+void set_volume(int percent)
+{
+    audio_output->set_volume(percent);
+    const int volume = audio_output->get_volume();
+    ESP_LOGI(TAG, "Volume %d %%", volume);
+
+#if CONFIG_NOSSAT_LVGL_GUI
+    gui->show_volume(volume);
+    const uint32_t display_id = ++volume_display_id;
+    event_loop->post_delayed(
+        [display_id]()
+        {
+            if (display_id == volume_display_id)
+                gui->show_current_page();
+        },
+        VOLUME_DISPLAY_MS);
+#endif
+
+    if (mqtt_manager)
+        mqtt_manager->publish("volume", std::to_string(volume));
+}
+
 #if CONFIG_NOSSAT_SPEECH_RECOGNITION
 
 std::shared_ptr<SpeechRecognition> speech_recognition;
@@ -106,29 +163,30 @@ class SpeechRecognitionObserver : public SpeechRecognition::IObserver
 public:
     void on_command_not_detected() override
     {
+        m_message_id++;
 #if CONFIG_NOSSAT_LVGL_GUI
         gui->show_message("Timeout");
 #endif
         led->solid(255, 0, 0);
-        audio_output->play(resource_manager.not_recognized_wav);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-#if CONFIG_NOSSAT_LVGL_GUI
-        gui->hide_message();
-#endif
-        led->clear();
+        LatencyProbes::instance().mark(LatencyProbes::Path::NOT_RECOGNIZED, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.open_stream(resource_manager.NOT_RECOGNIZED_PROMPT),
+                                 [this](bool) { hide_message_later(); });
     }
 
     void on_waiting_for_command() override
     {
+        m_message_id++;
 #if CONFIG_NOSSAT_LVGL_GUI
         gui->show_message("Say command");
 #endif
         led->solid(255, 255, 255);
-        audio_output->play(resource_manager.wake_wav);
+        LatencyProbes::instance().mark(LatencyProbes::Path::WAKE, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.wake_wav);
     }
 
     void on_command_handling_started(const char *message) override
     {
+        m_message_id++;
         led->solid(0, 255, 0);
 #if CONFIG_NOSSAT_LVGL_GUI
         gui->show_message(message);
@@ -137,13 +195,33 @@ public:
 
     void on_command_handling_finished() override
     {
-        audio_output->play(resource_manager.recognized_wav);
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        LatencyProbes::instance().mark(LatencyProbes::Path::COMMAND, LatencyProbes::Stage::PLAY_REQUESTED);
+        audio_output->play_async(resource_manager.open_stream(resource_manager.RECOGNIZED_PROMPT),
+                                 [this](bool) { hide_message_later(); });
+    }
+
+private:
+    // Keeps the message for a second after the prompt without blocking the
+    // event loop, unless a newer message has been shown meanwhile
+    void hide_message_later()
+    {
+        const uint32_t message_id = m_message_id;
+        event_loop->post_delayed(
+            [this, message_id]()
+            {
+                if (message_id != m_message_id)
+                    return;
 #if CONFIG_NOSSAT_LVGL_GUI
-        gui->hide_message();
+                gui->hide_message();
 #endif
-        led->clear();
+                led->clear();
+            },
+            1000);
     }
+
+private:
+    // all handlers run on the event loop
+    uint32_t m_message_id = 0;
 };
 
 void add_command(std::vector<const char *> commands)
@@ -205,47 +283,60 @@ void audio_feed_task()
 {
 #if CONFIG_NOSSAT_SPEECH_RECOGNITION
     const size_t audio_chunksize = speech_recognition->get_feed_chunksize();
+    // microphone channels followed by the AFE reference channel
+    const AudioFormat audio_format = SpeechRecognition::AUDIO_FORMAT;
+    const uint32_t reference_channel = audio_input->get_audio_format().num_channels;
+    const auto echo_reference = audio_output->get_echo_reference();
 #else
     // 16000
     const size_t audio_chunksize = 1024;
+    const AudioFormat audio_format = audio_input->get_audio_format();
 #endif
 
-    const AudioFormat audio_format = audio_input->get_audio_format();
     ESP_LOGI(TAG, "Run audio feed task: num_channels %lu, bits_per_sample %lu, sample_rate %lu",
              audio_format.num_channels, audio_format.bits_per_sample, audio_format.sample_rate);
 
-    // num samples per 100 ms
-    const size_t vis_step = audio_format.sample_rate * 0.05;
-    size_t vis_pos = 0;
-
-    AudioData audio;
+    // the microphones are captured and conditioned with their 24 significant
+    // bits, and only narrowed right before the AFE and the recorder
+    const AudioFormat &microphone_format = audio_input->get_audio_format();
+    AudioData captured(
+        AudioFormat{
+            .num_channels = microphone_format.num_channels,
+            .bits_per_sample = 32,
+            .sample_rate = microphone_format.sample_rate,
+        },
+        audio_chunksize);
+    // every later stage works in place or copies out of it
+    AudioData audio(audio_format, audio_chunksize);
+    AllocationTracker allocation_tracker(FEED_WARMUP_ITERATIONS);
+    CaptureHealth &capture_health = CaptureHealth::instance();
 
     while (true)
     {
-        audio.set_format(audio_format, audio_chunksize);
-        audio_input->capture_audio(audio);
+        const int64_t read_start_us = esp_timer_get_time();
+        const int64_t capture_time_us = audio_input->capture_audio(captured);
+        const int64_t read_end_us = esp_timer_get_time();
+        capture_health.record_read(read_end_us - read_start_us, capture_time_us);
 
-        if (recording)
+        capture_pipeline->process(captured);
+        audio_input->narrow_audio(captured, audio);
+#if CONFIG_NOSSAT_SPEECH_RECOGNITION
+        const uint32_t sample_time = EchoReference::get_sample_time(capture_time_us, audio_format.sample_rate);
+        echo_reference->read(audio, reference_channel, 0, sample_time);
+#endif
+
+        if (audio_recorder->is_recording())
         {
-            std::vector<int32_t> values;
-            while (vis_pos < audio.get_num_samples())
-            {
-                values.push_back(audio.get_value(vis_pos, 0));
-                vis_pos += vis_step;
-            }
-            vis_pos %= audio.get_num_samples();
-            gui->add_recording_data(values);
-
-            std::unique_lock<std::mutex> lock(recorded_audio_mutex);
-            if (recorded_audio.is_empty())
-                recorded_audio = audio;
-            else
-                recorded_audio.join(audio);
+            gui->add_recording_data(audio);
+            audio_recorder->append(audio);
         }
 #if CONFIG_NOSSAT_SPEECH_RECOGNITION
-        audio.add_channels(SpeechRecognition::REFERENCE_CHANNEL_COUNT);
+        const int64_t feed_start_us = esp_timer_get_time();
         speech_recognition->feed(audio);
+        capture_health.record_feed(esp_timer_get_time() - feed_start_us);
 #endif
+        capture_health.end_iteration(audio_input->get_num_overflows(), audio_input->get_num_dropped_samples());
+        allocation_tracker.end_iteration();
     }
 }
 
@@ -265,17 +356,32 @@ void initialize_sntp()
     }
 }
 
+// Publishes the capture health of the last interval on "<device>/capture/health" and restarts it. The report
+// waits for the feed task, so it is taken on its own task rather than blocking the event loop.
+void capture_health_task()
+{
+    while (true)
+    {
+        vTaskDelay(CAPTURE_HEALTH_PUBLISH_MS / portTICK_PERIOD_MS);
+        mqtt_manager->publish("capture/health", CaptureHealth::instance().take_report());
+    }
+}
+
 void start()
 {
     ESP_LOGI(TAG, "******* Initialize Interrupts and Events *******");
     interrupt_manager->initialize();
     create_task(std::bind(&EventLoop::run, event_loop), "Handle Task", 4 * 1024, configMAX_PRIORITIES - 1, 0);
 
+    audio_output = std::make_shared<AudioOutput>(event_loop);
+    capture_pipeline = create_capture_pipeline(audio_input->get_audio_format());
+
     led->solid(0, 0, 255);
 
 #if CONFIG_NOSSAT_LVGL_GUI
     display = std::make_shared<Display>();
     gui = std::make_shared<Gui>(display, event_loop);
+    gui->set_volume_changed_handler(set_volume);
     gui->show_message("Hello!");
     display->enable_backlight();
     std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -299,6 +405,39 @@ void start()
     ESP_LOGI(TAG, "Connect to MQTT");
     gui->show_message("Connecting to MQTT...");
     mqtt_manager = std::make_unique<MqttManager>(DEVICE_NAME);
+    // a message to "<device>/latency/get" is answered with the response time report on "<device>/latency"
+    mqtt_manager->subscribe("latency/get",
+                            [](const std::string &)
+                            { mqtt_manager->publish("latency", LatencyProbes::instance().get_report()); });
+    // "<device>/capture/get" is answered with the cycle cost of every capture stage and the capture health since
+    // the last periodic report on "<device>/capture"
+    mqtt_manager->subscribe("capture/get",
+                            [](const std::string &)
+                            {
+                                mqtt_manager->publish("capture", capture_pipeline->get_report() +
+                                                                     CaptureHealth::instance().get_report());
+                            });
+    // a WAV URL sent to "<device>/play", e.g. a Home Assistant TTS response, is played while it downloads
+    mqtt_manager->subscribe("play",
+                            [](const std::string &url)
+                            {
+                                auto stream = start_http_audio_stream(url, AudioOutput::AUDIO_FORMAT);
+                                // a media stream ducks under the chimes and prompts
+                                auto play = [stream]()
+                                { audio_output->play_async(stream, nullptr, AudioMixer::Priority::MEDIA); };
+                                // nobody would ever read the stream, closing it ends the download
+                                if (!event_loop->post(play))
+                                    stream->close();
+                            });
+    // "<device>/volume/set" takes 0-100, the applied volume is reported on "<device>/volume"
+    mqtt_manager->subscribe("volume/set",
+                            [](const std::string &message)
+                            {
+                                const int percent = std::atoi(message.c_str());
+                                event_loop->post([percent]() { set_volume(percent); });
+                            });
+    mqtt_manager->publish("volume", std::to_string(audio_output->get_volume()));
+    create_task(capture_health_task, "Capture Health", 4 * 1024, 1, 0);
 
 #if CONFIG_NOSSAT_SPEECH_RECOGNITION
     gui->show_message("Configuring Speech Recognition...");
@@ -309,6 +448,20 @@ void start()
 #endif
 
     ESP_LOGI(TAG, "******* Start audio capturing *******");
+#if CONFIG_NOSSAT_RECORDING_OVERWRITE_OLDEST
+    const auto recording_policy = AudioRecorder::FullPolicy::OVERWRITE_OLDEST;
+#else
+    const auto recording_policy = AudioRecorder::FullPolicy::STOP;
+#endif
+#if CONFIG_NOSSAT_RECORDING_ADPCM
+    const auto recording_encoding = AudioRecorder::Encoding::ADPCM;
+#else
+    const auto recording_encoding = AudioRecorder::Encoding::PCM;
+#endif
+    const AudioFormat &recording_format = audio_input->get_audio_format();
+    audio_recorder = std::make_unique<AudioRecorder>(recording_format,
+                                                     recording_format.sample_rate * CONFIG_NOSSAT_RECORDING_MAX_SECONDS,
+                                                     recording_policy, recording_encoding);
     create_task(audio_feed_task, "Feed Task", 4 * 1024, 5, 1);
 
     ESP_LOGI(TAG, "******* Ready! *******");
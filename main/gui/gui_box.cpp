@@ -1,6 +1,7 @@
 #include "gui_box.h"
 #include "esp_log.h"
 #include "lvgl/speech_recognition.h"
+#include "lvgl/volume_control.h"
 
 #include <mutex>
 
@@ -10,16 +11,31 @@ Gui::Gui(std::shared_ptr<Display> display) : m_display(display)
 {
     ESP_LOGI(TAG, "Configure LVGL");
     ui_initialize(display->get_lv_display());
+    ui_volume_initialize(display->get_lv_display());
 }
 
 void Gui::show_message(const char *message, bool animation)
 {
     std::unique_lock<Display> lock(*m_display);
     ui_show_message(message, animation);
+    m_message_visible = true;
 }
 
 void Gui::hide_message()
 {
     std::unique_lock<Display> lock(*m_display);
     ui_hide_message();
+    m_message_visible = false;
+}
+
+void Gui::show_volume(int percent)
+{
+    std::unique_lock<Display> lock(*m_display);
+    ui_show_volume(percent);
+}
+
+void Gui::hide_volume()
+{
+    std::unique_lock<Display> lock(*m_display);
+    ui_hide_volume();
 }
@@ -2,6 +2,8 @@
 
 #include "hal/display.h"
 
+#include <atomic>
+
 class Gui
 {
 public:
@@ -9,7 +11,13 @@ public:
 
     void show_message(const char *message, bool animation = false);
     void hide_message();
+    bool is_message_visible() const { return m_message_visible; }
+
+    // Volume arc over the screen, on top of any message
+    void show_volume(int percent);
+    void hide_volume();
 
 private:
     std::shared_ptr<Display> m_display;
+    std::atomic<bool> m_message_visible = false;
 };
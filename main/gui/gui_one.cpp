@@ -23,7 +23,9 @@ Gui::Gui(std::shared_ptr<Display> display, std::shared_ptr<EventLoop> event_loop
 
 void Gui::initialize_sound_chart()
 {
-    m_audio_serie = lv_chart_add_series(objects.sound_chart, lv_color_white(), LV_CHART_AXIS_PRIMARY_Y);
+    // the peaks of both signs outline the envelope
+    m_max_serie = lv_chart_add_series(objects.sound_chart, lv_color_white(), LV_CHART_AXIS_PRIMARY_Y);
+    m_min_serie = lv_chart_add_series(objects.sound_chart, lv_color_white(), LV_CHART_AXIS_PRIMARY_Y);
     lv_chart_set_point_count(objects.sound_chart, 100);
     lv_chart_set_range(objects.sound_chart, LV_CHART_AXIS_PRIMARY_Y, -1000, 1000);
     lv_chart_set_type(objects.sound_chart, LV_CHART_TYPE_LINE);
@@ -36,9 +38,8 @@ void Gui::initialize_knobs(std::shared_ptr<EventLoop> event_loop)
     ESP_LOGI(TAG, "Create left knob");
     m_left_encoder = std::make_shared<Knob>(event_loop, GPIO_LEFT_KNOB_S1, GPIO_LEFT_KNOB_S2, GPIO_LEFT_KNOB_KEY);
     m_left_encoder->set_step_value(2);
-    m_left_encoder->set_value_changed_handler([](int value) { ESP_LOGI(TAG, "[left] changed %d", value); });
-    m_left_encoder->set_left_handler(std::bind(&Gui::switch_to_screen, this, false));
-    m_left_encoder->set_right_handler(std::bind(&Gui::switch_to_screen, this, true));
+    m_left_encoder->set_value(100 / VOLUME_STEP, false);
+    m_left_encoder->set_click_handler(std::bind(&Gui::switch_to_screen, this, true));
 
     ESP_LOGI(TAG, "Create right knob");
     m_right_encoder =
@@ -63,18 +64,16 @@ void Gui::update_clock()
 
 void Gui::update_sound_chart()
 {
-    std::vector<int32_t> data;
-    {
-        std::unique_lock<std::mutex> lock(m_pending_sound_data_mutex);
-        std::swap(data, m_pending_sound_data);
-    }
-
-    if (data.size() == 0)
+    LevelMeter::Level level;
+    if (!m_level_meter.read(level))
         return;
 
     std::unique_lock<Display> lock(*m_display);
-    for (uint32_t value : data)
-        lv_chart_set_next_value(objects.sound_chart, m_audio_serie, value);
+    do
+    {
+        lv_chart_set_next_value(objects.sound_chart, m_max_serie, level.max);
+        lv_chart_set_next_value(objects.sound_chart, m_min_serie, level.min);
+    } while (m_level_meter.read(level));
 }
 
 void Gui::show_message(const char *message, bool animation)
@@ -84,6 +83,26 @@ void Gui::show_message(const char *message, bool animation)
     lv_scr_load_anim(objects.message_box, LV_SCR_LOAD_ANIM_FADE_IN, 200, 0, false);
 }
 
+void Gui::set_volume_changed_handler(ValueChangedHandler handler)
+{
+    m_left_encoder->set_value_changed_handler([handler](int value) { handler(value * VOLUME_STEP); });
+}
+
+void Gui::show_volume(int percent)
+{
+    // without notifying, the volume may be set off the knob steps over MQTT
+    if (m_left_encoder->get_value() != percent / VOLUME_STEP)
+        m_left_encoder->set_value(percent / VOLUME_STEP, false);
+
+    char text[16];
+    snprintf(text, sizeof(text), "Volume %d%%", percent);
+
+    std::unique_lock<Display> lock(*m_display);
+    lv_label_set_text(objects.message_label, text);
+    if (lv_scr_act() != objects.message_box)
+        lv_scr_load_anim(objects.message_box, LV_SCR_LOAD_ANIM_FADE_IN, 200, 0, false);
+}
+
 void Gui::show_current_page()
 {
     std::unique_lock<Display> lock(*m_display);
@@ -95,16 +114,15 @@ void Gui::show_current_page()
 void Gui::show_recording_screen()
 {
     std::unique_lock<Display> lock(*m_display);
-    lv_chart_set_all_value(objects.sound_chart, m_audio_serie, LV_CHART_POINT_NONE);
+    lv_chart_set_all_value(objects.sound_chart, m_max_serie, LV_CHART_POINT_NONE);
+    lv_chart_set_all_value(objects.sound_chart, m_min_serie, LV_CHART_POINT_NONE);
     lv_scr_load_anim(objects.sound_recorder, LV_SCR_LOAD_ANIM_FADE_IN, 200, 0, false);
     m_right_encoder->set_page(objects.sound_recorder);
 }
 
-void Gui::add_recording_data(const std::vector<int32_t> &values)
+void Gui::add_recording_data(ConstAudioView audio)
 {
-    ESP_LOGI(TAG, "Add audio data: %d points", static_cast<int>(values.size()));
-    std::unique_lock<std::mutex> lock(m_pending_sound_data_mutex);
-    m_pending_sound_data.insert(m_pending_sound_data.end(), values.begin(), values.end());
+    m_level_meter.write(audio);
 }
 
 lv_obj_t *Gui::get_page(int page_index)
@@ -7,19 +7,35 @@
 #include "hal/lvgl_knob.h"
 #include "lvgl_timer.h"
 #include "sound/audio_data.h"
+#include "sound/level_meter.h"
 
 class Gui
 {
 public:
     constexpr static const int PAGE_COUNT = 3;
+    // Volume change per step of the left knob
+    constexpr static const int VOLUME_STEP = 5;
+    // The sound chart shows the envelope of the microphone channels, the AFE
+    // reference after them is left out. One point per 50 ms.
+    constexpr static const uint32_t SOUND_CHART_CHANNELS = 2;
+    constexpr static const uint32_t SOUND_CHART_POINT_MS = 50;
+    // Points waiting for the chart timer, 3.2 s
+    constexpr static const size_t MAX_PENDING_SOUND_POINTS = 64;
 
     Gui(std::shared_ptr<Display> display, std::shared_ptr<EventLoop> event_loop);
 
     void show_message(const char *message, bool animation = false);
+    void hide_message() { show_current_page(); }
     void show_current_page();
 
+    // The left knob sets the volume, the handler gets 0-100 % unclamped
+    void set_volume_changed_handler(ValueChangedHandler handler);
+    // Shows the volume in the message box and keeps the knob in step with it
+    void show_volume(int percent);
+
     void show_recording_screen();
-    void add_recording_data(const std::vector<int32_t> &values);
+    // Called by the audio task, 16-bit audio
+    void add_recording_data(ConstAudioView audio);
 
 private:
     lv_obj_t *get_page(int page_index);
@@ -37,9 +53,10 @@ private:
     std::shared_ptr<LvglKnob> m_right_encoder;
     std::shared_ptr<LvglTimer> m_clock_timer;
 
-    lv_chart_series_t *m_audio_serie = nullptr;
+    lv_chart_series_t *m_max_serie = nullptr;
+    lv_chart_series_t *m_min_serie = nullptr;
 
     std::shared_ptr<LvglTimer> m_sound_chart_timer;
-    std::vector<int32_t> m_pending_sound_data;
-    std::mutex m_pending_sound_data_mutex;
+    // written by the audio task, read by the chart timer
+    LevelMeter m_level_meter{SOUND_CHART_CHANNELS, SOUND_CHART_POINT_MS, MAX_PENDING_SOUND_POINTS};
 };
@@ -2,71 +2,53 @@
 
 #include <stdio.h>
 
-#include "bsp/esp-bsp.h"
+#include "gui/lvgl/font/font_en_24.h"
 
-lv_obj_t *arc = 0;
-lv_obj_t *label = 0;
-lv_disp_t *main_disp = 0;
-// static void set_angle(void *obj, int32_t v)
-// {
-//     lv_arc_set_value(obj, v);
-// }
-void set_label_style(lv_obj_t *label)
-{
-    // Create a new style
-    static lv_style_t style;
-    lv_style_init(&style);
-
-    // Set the text color to white
-    lv_style_set_text_color(&style, lv_color_white());
-    lv_style_set_text_align(&style, LV_TEXT_ALIGN_CENTER);
-
-    // Apply the style to the label
-    lv_obj_add_style(label, &style, 0);
-}
+static lv_obj_t *g_volume_mask = NULL;
+static lv_obj_t *g_volume_arc = NULL;
+static lv_obj_t *g_volume_label = NULL;
 
-void ui_lvgl_main(lv_disp_t *disp)
+void ui_volume_initialize(lv_disp_t *disp)
 {
-    main_disp = disp;
-
     lv_obj_t *scr = lv_disp_get_scr_act(disp);
-    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
-
-    /*Create an Arc*/
-    arc = lv_arc_create(scr);
-    lv_arc_set_rotation(arc, 270);
-    lv_arc_set_bg_angles(arc, 0, 360);
-    lv_obj_remove_style(arc, NULL, LV_PART_KNOB);  /*Be sure the knob is not displayed*/
-    lv_obj_clear_flag(arc, LV_OBJ_FLAG_CLICKABLE); /*To not allow adjusting by click*/
-    lv_obj_set_size(arc, 100, 100);
-    lv_obj_center(arc);
-    lv_arc_set_value(arc, 0);
+    g_volume_mask = lv_obj_create(scr);
+    lv_obj_set_size(g_volume_mask, lv_obj_get_width(scr), lv_obj_get_height(scr));
+    lv_obj_clear_flag(g_volume_mask, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(g_volume_mask, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_style_radius(g_volume_mask, 0, LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(g_volume_mask, 0, LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_color(g_volume_mask, lv_color_black(), LV_STATE_DEFAULT);
+    lv_obj_align(g_volume_mask, LV_ALIGN_CENTER, 0, 0);
+
+    g_volume_arc = lv_arc_create(g_volume_mask);
+    lv_arc_set_rotation(g_volume_arc, 270);
+    lv_arc_set_bg_angles(g_volume_arc, 0, 360);
+    lv_arc_set_range(g_volume_arc, 0, 100);
+    lv_obj_remove_style(g_volume_arc, NULL, LV_PART_KNOB);  /*Be sure the knob is not displayed*/
+    lv_obj_clear_flag(g_volume_arc, LV_OBJ_FLAG_CLICKABLE); /*To not allow adjusting by click*/
+    lv_obj_set_size(g_volume_arc, 140, 140);
+    lv_obj_center(g_volume_arc);
+
+    g_volume_label = lv_label_create(g_volume_mask);
+    lv_obj_set_style_text_font(g_volume_label, &font_en_24, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(g_volume_label, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_set_style_text_align(g_volume_label, LV_TEXT_ALIGN_CENTER, LV_STATE_DEFAULT);
+    lv_obj_align(g_volume_label, LV_ALIGN_CENTER, 0, 0);
+}
 
-    label = lv_label_create(scr);
-    lv_obj_set_width(label, 70);  /// 1
-    lv_obj_set_height(label, 25); /// 1
-    // lv_obj_set_align(label, LV_ALIGN_CENTER);
-    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+void ui_show_volume(int32_t percent)
+{
+    lv_arc_set_value(g_volume_arc, percent);
 
-    set_label_style(label);
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d %%", (int)(percent));
+    lv_label_set_text(g_volume_label, buf);
 
-    lv_label_set_text(label, "0%");
-    // lv_anim_t a;
-    // lv_anim_init(&a);
-    // lv_anim_set_var(&a, arc);
-    // lv_anim_set_exec_cb(&a, set_angle);
-    // lv_anim_set_time(&a, 1000);
-    // lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE); /*Just for the demo*/
-    // lv_anim_set_repeat_delay(&a, 500);
-    // lv_anim_set_values(&a, 0, 100);
-    // lv_anim_start(&a);
+    lv_obj_move_foreground(g_volume_mask);
+    lv_obj_clear_flag(g_volume_mask, LV_OBJ_FLAG_HIDDEN);
 }
 
-void ui_set_value(int32_t v)
+void ui_hide_volume(void)
 {
-    lv_arc_set_value(arc, v);
-
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%d %%", (int)(v));
-    lv_label_set_text(label, buf);
-}
\ No newline at end of file
+    lv_obj_add_flag(g_volume_mask, LV_OBJ_FLAG_HIDDEN);
+}
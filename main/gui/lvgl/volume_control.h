@@ -7,8 +7,10 @@ extern "C"
 {
 #endif
 
-void ui_lvgl_main(lv_disp_t *disp);
-void ui_set_value(int32_t v);
+// Volume arc shown over the screen while the volume changes
+void ui_volume_initialize(lv_disp_t *disp);
+void ui_show_volume(int32_t percent);
+void ui_hide_volume(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,53 @@
+#include "audio_capture.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "audio_capture";
+
+AudioCapture::AudioCapture(const AudioFormat &format, size_t frame_samples, size_t num_frames)
+    : m_ring(format, frame_samples, num_frames)
+{
+}
+
+bool AudioCapture::push_from_isr(const void *data)
+{
+    m_ring.push(data, esp_timer_get_time());
+
+    const TaskHandle_t reader = m_reader.load(std::memory_order_relaxed);
+    if (reader == nullptr)
+        return false;
+
+    BaseType_t high_task_awoken = pdFALSE;
+    vTaskNotifyGiveFromISR(reader, &high_task_awoken);
+    return high_task_awoken == pdTRUE;
+}
+
+void AudioCapture::push(const void *data)
+{
+    m_ring.push(data, esp_timer_get_time());
+
+    const TaskHandle_t reader = m_reader.load(std::memory_order_relaxed);
+    if (reader != nullptr)
+        xTaskNotifyGive(reader);
+}
+
+const CaptureRing::Frame &AudioCapture::wait_for_frame()
+{
+    // the reader is whoever reads, a notification given before it waits is kept
+    m_reader.store(xTaskGetCurrentTaskHandle(), std::memory_order_relaxed);
+
+    const CaptureRing::Frame *frame = nullptr;
+    while ((frame = m_ring.front()) == nullptr)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    if (m_frame_position == 0 && frame->sequence != m_next_sequence)
+    {
+        m_num_overflows.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "Reader fell behind, %d frames dropped (%d total)",
+                 static_cast<int>(frame->sequence - m_next_sequence),
+                 static_cast<int>(m_ring.get_num_dropped_frames()));
+    }
+    m_next_sequence = frame->sequence + 1;
+    return *frame;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "sound/capture_ring.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Hands the frames of the capture DMA to the one task that reads them. The
+// producer never waits for the reader, a stall downstream only drops whole
+// frames, which are counted, and the timestamps of the frames keep the
+// capture timeline right for the audio that is read.
+class AudioCapture
+{
+public:
+    AudioCapture(const AudioFormat &format, size_t frame_samples, size_t num_frames);
+
+    // Producer in the DMA ISR, returns whether a higher priority task was woken
+    bool push_from_isr(const void *data);
+    // Producer in a task
+    void push(const void *data);
+
+    // Consumer: blocks until audio is filled, convert(frame part, audio part)
+    // copies one run of samples out of a frame. Returns the time the last
+    // sample was captured at.
+    template <typename Convert> int64_t read(AudioView audio, Convert convert);
+
+    size_t get_num_dropped_samples() const { return m_ring.get_num_dropped_frames() * m_ring.get_frame_samples(); }
+    // Times the reader found frames missing, each after the ring ran full
+    size_t get_num_overflows() const { return m_num_overflows.load(std::memory_order_relaxed); }
+    const AudioFormat &get_format() const { return m_ring.get_format(); }
+
+private:
+    const CaptureRing::Frame &wait_for_frame();
+
+private:
+    CaptureRing m_ring;
+    std::atomic<TaskHandle_t> m_reader = nullptr;
+
+    // Consumer side
+    size_t m_frame_position = 0;
+    uint32_t m_next_sequence = 0;
+    std::atomic<size_t> m_num_overflows = 0;
+};
+
+template <typename Convert> int64_t AudioCapture::read(AudioView audio, Convert convert)
+{
+    const size_t frame_samples = m_ring.get_frame_samples();
+    const int64_t sample_rate = m_ring.get_format().sample_rate;
+
+    int64_t time_us = 0;
+    size_t position = 0;
+    while (position < audio.get_num_samples())
+    {
+        const CaptureRing::Frame &frame = wait_for_frame();
+        const size_t count = std::min(frame_samples - m_frame_position, audio.get_num_samples() - position);
+        convert(frame.audio.subview(m_frame_position, count), audio.subview(position, count));
+        position += count;
+        m_frame_position += count;
+
+        // the frame was stamped when its last sample arrived
+        time_us = frame.time_us - static_cast<int64_t>(frame_samples - m_frame_position) * 1000000 / sample_rate;
+        if (m_frame_position == frame_samples)
+        {
+            m_ring.pop();
+            m_frame_position = 0;
+        }
+    }
+    return time_us;
+}
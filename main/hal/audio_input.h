@@ -11,9 +11,24 @@ public:
     AudioInput();
     ~AudioInput();
 
-    void capture_audio(AudioData &audio);
+    // The microphone is drained into a capture ring as the DMA fills its
+    // buffers, this pulls the next audio from it and returns the time its
+    // last sample was captured at (esp_timer clock). audio may have more
+    // channels than the microphone format, the extra channels (e.g. AFE
+    // reference) are zero filled. The INMP441 input also captures into 32-bit
+    // audio keeping all 24 significant bits.
+    int64_t capture_audio(AudioView audio);
+    // Narrows left justified 32-bit audio, e.g. captured and conditioned, into
+    // the 16-bit layout of audio with the gain capture_audio() applies to
+    // 16-bit audio. Saturates, extra output channels are zero filled.
+    void narrow_audio(ConstAudioView captured, AudioView audio) const;
     const AudioFormat &get_audio_format() const;
 
+    // Audio lost because the reader fell behind by more than the capture ring
+    size_t get_num_dropped_samples() const;
+    // Times the reader fell behind and audio was dropped
+    size_t get_num_overflows() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> m_impl;
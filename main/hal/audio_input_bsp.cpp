@@ -1,8 +1,13 @@
 #include "audio_input.h"
+#include "audio_capture.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
 #include "driver/i2s_std.h"
 #include "nossat_err.h"
+#include "sound/audio_convert.h"
+#include "system/task.h"
+
+#include <cstring>
 
 static const char *TAG = "audio_input";
 
@@ -14,6 +19,12 @@ static const AudioFormat MICROPHONE_AUDIO_FORMAT = {
 
 const constexpr float CODEC_DEFAULT_ADC_VOLUME = 24.0;
 
+// The BSP owns the I2S channel behind the codec device, so a capture task of
+// a high priority drains it into the capture ring in 10 ms frames instead of
+// a DMA callback. The ring absorbs 320 ms of stalls downstream.
+constexpr const size_t CAPTURE_FRAME_SAMPLES = 160;
+constexpr const size_t CAPTURE_RING_FRAMES = 32;
+
 static esp_codec_dev_sample_info_t make_codec_config(const AudioFormat &format)
 {
     return esp_codec_dev_sample_info_t{
@@ -28,8 +39,21 @@ static esp_codec_dev_sample_info_t make_codec_config(const AudioFormat &format)
 struct AudioInput::Impl
 {
     esp_codec_dev_handle_t rx_handle = 0;
+    AudioCapture capture{MICROPHONE_AUDIO_FORMAT, CAPTURE_FRAME_SAMPLES, CAPTURE_RING_FRAMES};
+
+    void capture_task();
 };
 
+void AudioInput::Impl::capture_task()
+{
+    AudioData frame(MICROPHONE_AUDIO_FORMAT, CAPTURE_FRAME_SAMPLES);
+    while (true)
+    {
+        esp_codec_dev_read(rx_handle, frame.get_data(), frame.get_size());
+        capture.push(frame.get_data());
+    }
+}
+
 AudioInput::AudioInput() : m_impl(std::make_unique<Impl>())
 {
     ESP_LOGI(TAG, "Initialize microphone via BSP");
@@ -43,6 +67,8 @@ AudioInput::AudioInput() : m_impl(std::make_unique<Impl>())
 
     esp_codec_dev_sample_info_t config = make_codec_config(MICROPHONE_AUDIO_FORMAT);
     ESP_ERROR_CHECK(esp_codec_dev_open(m_impl->rx_handle, &config));
+
+    create_task(std::bind(&Impl::capture_task, m_impl.get()), "Capture Task", 3 * 1024, 7, 1);
 }
 
 AudioInput::~AudioInput()
@@ -54,8 +80,34 @@ const AudioFormat &AudioInput::get_audio_format() const
     return MICROPHONE_AUDIO_FORMAT;
 }
 
-void AudioInput::capture_audio(AudioData &audio)
+int64_t AudioInput::capture_audio(AudioView audio)
+{
+    assert(audio.get_bits_per_sample() == MICROPHONE_AUDIO_FORMAT.bits_per_sample);
+    assert(audio.get_sample_rate() == MICROPHONE_AUDIO_FORMAT.sample_rate);
+    assert(audio.get_num_channels() >= MICROPHONE_AUDIO_FORMAT.num_channels);
+
+    return m_impl->capture.read(audio,
+                                [](ConstAudioView frame, AudioView output)
+                                {
+                                    memcpy(output.get_data(), frame.get_data(), frame.get_size());
+                                    expand_channels(output, frame.get_num_channels());
+                                });
+}
+
+void AudioInput::narrow_audio(ConstAudioView captured, AudioView audio) const
+{
+    assert(captured.get_bits_per_sample() == 32 && captured.get_num_samples() == audio.get_num_samples());
+
+    // the codec delivers 16-bit audio, Q31 narrows without gain
+    narrow_interleave_i32_to_i16(captured.get_data_typed<int32_t>(), captured.get_num_channels(), audio, 16);
+}
+
+size_t AudioInput::get_num_dropped_samples() const
+{
+    return m_impl->capture.get_num_dropped_samples();
+}
+
+size_t AudioInput::get_num_overflows() const
 {
-    assert(audio.get_format() == MICROPHONE_AUDIO_FORMAT);
-    esp_codec_dev_read(m_impl->rx_handle, audio.get_data(), audio.get_size());
+    return m_impl->capture.get_num_overflows();
 }
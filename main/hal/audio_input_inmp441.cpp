@@ -1,8 +1,10 @@
 #include "audio_input.h"
+#include "audio_capture.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
 #include "driver/i2s_std.h"
 #include "freertos/FreeRTOS.h"
+#include "sound/audio_convert.h"
 
 static const AudioFormat MICROPHONE_AUDIO_FORMAT = {
     .num_channels = 2,
@@ -10,19 +12,46 @@ static const AudioFormat MICROPHONE_AUDIO_FORMAT = {
     .sample_rate = 16000,
 };
 
+// Native I2S layout: every slot is 32 bits wide with 24 valid bits on top
+static const AudioFormat I2S_AUDIO_FORMAT = {
+    .num_channels = 2,
+    .bits_per_sample = 32,
+    .sample_rate = 16000,
+};
+
 constexpr const auto SLOT_MODE = I2S_SLOT_MODE_STEREO;
 constexpr const auto DATA_BIT_WIDTH = I2S_DATA_BIT_WIDTH_32BIT;
+constexpr const int SAMPLE_SHIFT = 14;
+
+// The DMA completes a buffer every 10 ms and the ISR moves it into the
+// capture ring right away, which absorbs 320 ms of stalls downstream
+constexpr const uint32_t DMA_DESC_NUM = 4;
+constexpr const uint32_t DMA_FRAME_NUM = 160;
+constexpr const size_t CAPTURE_RING_FRAMES = 32;
 
 struct AudioInput::Impl
 {
     i2s_chan_handle_t rx_handle = nullptr;
-    std::vector<int32_t> temp_buffer;
+    AudioCapture capture{I2S_AUDIO_FORMAT, DMA_FRAME_NUM, CAPTURE_RING_FRAMES};
+
+    void create_channel();
+
+    static bool on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
 };
 
-static i2s_chan_handle_t bsp_i2s_microphone_init()
+// Runs in the ISR each time the DMA has filled a buffer
+bool IRAM_ATTR AudioInput::Impl::on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    auto impl = static_cast<Impl *>(user_ctx);
+    // data points at the pointer to the DMA buffer
+    return impl->capture.push_from_isr(*static_cast<void **>(event->data));
+}
+
+void AudioInput::Impl::create_channel()
 {
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_AUDIO, I2S_ROLE_MASTER);
-    i2s_chan_handle_t rx_handle;
+    chan_cfg.dma_desc_num = DMA_DESC_NUM;
+    chan_cfg.dma_frame_num = DMA_FRAME_NUM;
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &rx_handle));
     i2s_std_config_t std_cfg = {
         .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(MICROPHONE_AUDIO_FORMAT.sample_rate),
@@ -44,14 +73,16 @@ static i2s_chan_handle_t bsp_i2s_microphone_init()
     };
 
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle, &std_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(rx_handle));
 
-    return rx_handle;
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_recv = on_recv;
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(rx_handle, &callbacks, this));
+    ESP_ERROR_CHECK(i2s_channel_enable(rx_handle));
 }
 
 AudioInput::AudioInput() : m_impl(std::make_unique<Impl>())
 {
-    m_impl->rx_handle = bsp_i2s_microphone_init();
+    m_impl->create_channel();
 }
 
 AudioInput::~AudioInput()
@@ -63,26 +94,48 @@ const AudioFormat &AudioInput::get_audio_format() const
     return MICROPHONE_AUDIO_FORMAT;
 }
 
-void AudioInput::capture_audio(AudioData &audio)
+int64_t AudioInput::capture_audio(AudioView audio)
 {
-    assert(audio.get_format() == MICROPHONE_AUDIO_FORMAT);
-
-    const size_t num_samples = audio.get_num_samples();
-    m_impl->temp_buffer.resize(num_samples * audio.get_num_channels());
+    assert(audio.get_bits_per_sample() == MICROPHONE_AUDIO_FORMAT.bits_per_sample ||
+           audio.get_bits_per_sample() == 32);
+    assert(!audio.get_format().floating_point);
+    assert(audio.get_sample_rate() == MICROPHONE_AUDIO_FORMAT.sample_rate);
+    assert(audio.get_num_channels() >= MICROPHONE_AUDIO_FORMAT.num_channels);
 
-    size_t bytes_read;
-    ESP_ERROR_CHECK(i2s_channel_read(m_impl->rx_handle, m_impl->temp_buffer.data(),
-                                     m_impl->temp_buffer.size() * sizeof(int32_t), &bytes_read, portMAX_DELAY));
-
-    int16_t *output = audio.get_data_typed<int16_t>();
-    for (int i = 0; i < num_samples; i++)
+    if (audio.get_bits_per_sample() == 32)
     {
-        // 32:8 are valid bits, 8:0 are the lower 8 bits, all are 0. The input
-        // of AFE is 16-bit voice data, and 29:13 bits are used to amplify the
-        // voice signal.
-        // https://invensense.tdk.com/wp-content/uploads/2015/02/INMP441.pdf
-        const int offset = i * audio.get_num_channels();
-        output[offset + 1] = m_impl->temp_buffer[offset + 1] >> 14;
-        output[offset] = m_impl->temp_buffer[offset] >> 14;
+        // left justified 24-bit samples keep their full precision
+        return m_impl->capture.read(audio,
+                                    [](ConstAudioView frame, AudioView output)
+                                    {
+                                        interleave_i32(frame.get_data_typed<int32_t>(), frame.get_num_channels(),
+                                                       output);
+                                    });
     }
+
+    return m_impl->capture.read(audio,
+                                [this](ConstAudioView frame, AudioView output) { narrow_audio(frame, output); });
+}
+
+void AudioInput::narrow_audio(ConstAudioView captured, AudioView audio) const
+{
+    assert(captured.get_bits_per_sample() == 32 && captured.get_num_samples() == audio.get_num_samples());
+
+    // 32:8 are valid bits, 8:0 are the lower 8 bits, all are 0. The input
+    // of AFE is 16-bit voice data, and 29:13 bits are used to amplify the
+    // voice signal, louder samples saturate. Extra output channels (AFE
+    // reference) are zero filled in the same pass.
+    // https://invensense.tdk.com/wp-content/uploads/2015/02/INMP441.pdf
+    narrow_interleave_i32_to_i16(captured.get_data_typed<int32_t>(), captured.get_num_channels(), audio,
+                                 SAMPLE_SHIFT);
+}
+
+size_t AudioInput::get_num_dropped_samples() const
+{
+    return m_impl->capture.get_num_dropped_samples();
+}
+
+size_t AudioInput::get_num_overflows() const
+{
+    return m_impl->capture.get_num_overflows();
 }
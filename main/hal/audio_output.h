@@ -1,15 +1,43 @@
 #pragma once
 
+#include "hal/playback.h"
 #include "sound/audio_data.h"
+#include "system/event_loop.h"
+
 #include <memory>
 
 class AudioOutput
 {
 public:
-    AudioOutput();
+    // Native format of the speaker path, audio has to be converted to it before playing
+    static const AudioFormat AUDIO_FORMAT;
+
+    explicit AudioOutput(std::shared_ptr<EventLoop> event_loop);
     ~AudioOutput();
 
-    bool play(const AudioData &audio);
+    // Starts playing audio over the other playbacks and returns at once. audio
+    // is not copied, it has to stay valid until the playback is finished.
+    // on_finished is posted to the event loop. Playbacks of a lower priority
+    // are ducked while this one plays.
+    std::shared_ptr<Playback> play_async(ConstAudioView audio, Playback::Callback on_finished = nullptr,
+                                         AudioMixer::Priority priority = AudioMixer::Priority::FEEDBACK,
+                                         Gain gain = GAIN_UNITY);
+    // Plays an opened stream, it is decoded while playing
+    std::shared_ptr<Playback> play_async(std::unique_ptr<WavStream> stream, Playback::Callback on_finished = nullptr,
+                                         AudioMixer::Priority priority = AudioMixer::Priority::FEEDBACK,
+                                         Gain gain = GAIN_UNITY);
+    // Plays a jitter buffer while its producer downloads into it
+    std::shared_ptr<Playback> play_async(std::shared_ptr<JitterBuffer> jitter_buffer,
+                                         Playback::Callback on_finished = nullptr,
+                                         AudioMixer::Priority priority = AudioMixer::Priority::FEEDBACK,
+                                         Gain gain = GAIN_UNITY);
+
+    // Master volume of 0-100 %, applied on the fly to everything that plays
+    void set_volume(int percent);
+    int get_volume() const;
+
+    // Loopback of the speaker signal for the AFE reference channel
+    std::shared_ptr<EchoReference> get_echo_reference() const;
 
 private:
     struct Impl;
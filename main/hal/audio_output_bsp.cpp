@@ -2,10 +2,15 @@
 #include "esp_log.h"
 #include "bsp/esp-bsp.h"
 #include "nossat_err.h"
+#include "sdkconfig.h"
+#include "sound/audio_gain.h"
+
+#include <algorithm>
+#include <cstring>
 
 static const char *TAG = "audio_output";
 
-static const AudioFormat SPEAKER_AUDIO_FORMAT = {
+const AudioFormat AudioOutput::AUDIO_FORMAT = {
     .num_channels = 2,
     .bits_per_sample = 16,
     .sample_rate = 16000,
@@ -22,38 +27,169 @@ static esp_codec_dev_sample_info_t make_codec_config(const AudioFormat &format)
     };
 }
 
-struct AudioOutput::Impl
+// Playbacks are mixed in chunks of 20 ms
+constexpr const size_t CHUNK_SAMPLES = 320;
+// Pop suppression ramps of 5 ms
+constexpr const size_t FADE_SAMPLES = 80;
+// The BSP opens the speaker I2S channel with the default DMA ring of 6
+// buffers of 240 frames, 90 ms that are queued but not yet played
+constexpr const size_t DMA_RING_SAMPLES = 6 * 240;
+
+// The codec is kept open and muted in between playbacks. A playback only
+// unmutes it and fades in, at the end the output fades out from the last
+// sample and is muted again. The codec is closed after the idle timeout.
+struct AudioOutput::Impl : PlaybackMixer::ISink
 {
+    enum class CodecState {
+        CLOSED,
+        IDLE,
+        ACTIVE,
+    };
+
     esp_codec_dev_handle_t play_dev_handle = 0;
+    CodecState codec_state = CodecState::CLOSED;
+    bool fading_in = false;
+    // faded chunks and the last written sample for the fade-out
+    AudioData fade_chunk = AudioData(AUDIO_FORMAT, CHUNK_SAMPLES);
+    AudioData last_sample = AudioData(AUDIO_FORMAT, 1);
+    std::unique_ptr<PlaybackMixer> mixer;
+
+    void open_codec();
+    void write_codec(ConstAudioView audio);
+
+    void begin() override;
+    void write(ConstAudioView audio) override;
+    void end() override;
+    size_t get_latency_samples() const override { return DMA_RING_SAMPLES; }
+    void sleep() override;
 };
 
-AudioOutput::AudioOutput() : m_impl(std::make_unique<Impl>())
+void AudioOutput::Impl::open_codec()
+{
+    esp_codec_dev_sample_info_t config = make_codec_config(AUDIO_FORMAT);
+    ESP_ERROR_CHECK(esp_codec_dev_open(play_dev_handle, &config));
+    ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(play_dev_handle, true));
+    ESP_ERROR_CHECK(esp_codec_dev_set_out_vol(play_dev_handle, 100));
+    codec_state = CodecState::IDLE;
+}
+
+void AudioOutput::Impl::write_codec(ConstAudioView audio)
+{
+    esp_codec_dev_write(play_dev_handle, const_cast<int8_t *>(audio.get_data()), audio.get_size());
+}
+
+void AudioOutput::Impl::begin()
+{
+    if (codec_state == CodecState::CLOSED)
+    {
+        ESP_LOGI(TAG, "Wake up speaker codec");
+        open_codec();
+    }
+    ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(play_dev_handle, false));
+    codec_state = CodecState::ACTIVE;
+    fading_in = true;
+}
+
+void AudioOutput::Impl::write(ConstAudioView audio)
+{
+    const size_t num_samples = audio.get_num_samples();
+    memcpy(last_sample.get_data(), audio.subview(num_samples - 1, 1).get_data(), last_sample.get_size());
+
+    if (!fading_in)
+    {
+        write_codec(audio);
+        return;
+    }
+
+    fading_in = false;
+    const AudioView chunk = fade_chunk.view().subview(0, num_samples);
+    memcpy(chunk.get_data(), audio.get_data(), audio.get_size());
+    const size_t fade_samples = std::min(FADE_SAMPLES, num_samples);
+    apply_gain_ramp(chunk.subview(0, fade_samples), 0, GAIN_UNITY);
+    write_codec(chunk);
+}
+
+void AudioOutput::Impl::end()
+{
+    // ramps from the last sample down to silence
+    const AudioView chunk = fade_chunk.view();
+    for (size_t i = 0; i < FADE_SAMPLES; i++)
+        memcpy(chunk.subview(i, 1).get_data(), last_sample.get_data(), last_sample.get_size());
+    apply_gain_ramp(chunk.subview(0, FADE_SAMPLES), GAIN_UNITY, 0);
+    memset(chunk.subview(FADE_SAMPLES, CHUNK_SAMPLES - FADE_SAMPLES).get_data(), 0,
+           (CHUNK_SAMPLES - FADE_SAMPLES) * AUDIO_FORMAT.get_sample_size());
+    write_codec(chunk);
+
+    // writes block while the DMA ring is full, so once a whole ring of
+    // silence is queued behind the fade-out, the prompt and the fade have
+    // been played and only silence is left to replay after the next unmute
+    memset(chunk.get_data(), 0, chunk.get_size());
+    for (size_t written = 0; written < DMA_RING_SAMPLES; written += CHUNK_SAMPLES)
+        write_codec(chunk);
+
+    ESP_ERROR_CHECK(esp_codec_dev_set_out_mute(play_dev_handle, true));
+    codec_state = CodecState::IDLE;
+}
+
+void AudioOutput::Impl::sleep()
+{
+    if (codec_state != CodecState::IDLE)
+        return;
+
+    ESP_LOGI(TAG, "Power down idle speaker codec");
+    ESP_ERROR_CHECK(esp_codec_dev_close(play_dev_handle));
+    codec_state = CodecState::CLOSED;
+}
+
+AudioOutput::AudioOutput(std::shared_ptr<EventLoop> event_loop) : m_impl(std::make_unique<Impl>())
 {
     ESP_LOGI(TAG, "Initialize speaker via BSP");
     ESP_ERROR_CHECK(bsp_i2c_init());
     m_impl->play_dev_handle = bsp_audio_codec_speaker_init();
     ESP_TRUE_CHECK(m_impl->play_dev_handle);
     ESP_ERROR_CHECK(esp_codec_dev_close(m_impl->play_dev_handle));
-    esp_codec_dev_sample_info_t config = make_codec_config(SPEAKER_AUDIO_FORMAT);
-    ESP_ERROR_CHECK(esp_codec_dev_open(m_impl->play_dev_handle, &config));
+    m_impl->open_codec();
+    m_impl->mixer = std::make_unique<PlaybackMixer>(event_loop, *m_impl, AUDIO_FORMAT, CHUNK_SAMPLES,
+                                                    CONFIG_NOSSAT_CODEC_IDLE_TIMEOUT_MS);
 }
 
 AudioOutput::~AudioOutput()
 {
 }
 
-bool AudioOutput::play(const AudioData &audio)
+std::shared_ptr<Playback> AudioOutput::play_async(ConstAudioView audio, Playback::Callback on_finished,
+                                                  AudioMixer::Priority priority, Gain gain)
 {
+    assert(audio.get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(audio, std::move(on_finished), priority, gain);
+}
 
-    esp_err_t ret = esp_codec_dev_close(m_impl->play_dev_handle);
-    esp_codec_dev_sample_info_t config = make_codec_config(SPEAKER_AUDIO_FORMAT);
-    ret |= esp_codec_dev_open(m_impl->play_dev_handle, &config);
-    ret |= esp_codec_dev_set_out_mute(m_impl->play_dev_handle, true);
-    ret |= esp_codec_dev_set_out_mute(m_impl->play_dev_handle, false);
-    ret |= esp_codec_dev_set_out_vol(m_impl->play_dev_handle, 100);
-    vTaskDelay(pdMS_TO_TICKS(50));
-    ret |= esp_codec_dev_write(m_impl->play_dev_handle, const_cast<int8_t *>(audio.get_data()), audio.get_size());
-    vTaskDelay(pdMS_TO_TICKS(20));
+std::shared_ptr<Playback> AudioOutput::play_async(std::unique_ptr<WavStream> stream, Playback::Callback on_finished,
+                                                  AudioMixer::Priority priority, Gain gain)
+{
+    assert(stream->get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(std::move(stream), std::move(on_finished), priority, gain);
+}
 
-    return true;
+std::shared_ptr<Playback> AudioOutput::play_async(std::shared_ptr<JitterBuffer> jitter_buffer,
+                                                  Playback::Callback on_finished, AudioMixer::Priority priority,
+                                                  Gain gain)
+{
+    assert(jitter_buffer->get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(std::move(jitter_buffer), std::move(on_finished), priority, gain);
+}
+
+void AudioOutput::set_volume(int percent)
+{
+    m_impl->mixer->set_volume(percent);
+}
+
+int AudioOutput::get_volume() const
+{
+    return m_impl->mixer->get_volume();
+}
+
+std::shared_ptr<EchoReference> AudioOutput::get_echo_reference() const
+{
+    return m_impl->mixer->get_echo_reference();
 }
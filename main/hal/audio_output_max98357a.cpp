@@ -5,30 +5,67 @@
 #include "driver/gpio.h"
 #include "bsp/esp-bsp.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
-struct AudioOutput::Impl
-{
+const AudioFormat AudioOutput::AUDIO_FORMAT = {
+    .num_channels = 2,
+    .bits_per_sample = 16,
+    .sample_rate = 16000,
 };
 
-AudioOutput::AudioOutput() : m_impl(std::make_unique<Impl>())
+// DMA ring of 4 buffers of 10 ms: a queued buffer starts playing within 40 ms
+// and the channel outputs silence from the auto cleared buffers when idle
+constexpr const uint32_t DMA_DESC_NUM = 4;
+constexpr const uint32_t DMA_FRAME_NUM = 160;
+// Playbacks are mixed in chunks of 20 ms
+constexpr const size_t CHUNK_SAMPLES = 320;
+
+// Owns the TX channel for the whole lifetime of the output. The channel is
+// configured and enabled once, the playback mixer streams into the DMA ring
+// so a playback never pays for channel setup.
+struct AudioOutput::Impl : PlaybackMixer::ISink
 {
-}
+    i2s_chan_handle_t tx_handle = nullptr;
+    TaskHandle_t task = nullptr;
+    std::unique_ptr<PlaybackMixer> mixer;
 
-AudioOutput::~AudioOutput()
+    void create_channel();
+
+    void begin() override;
+    void write(ConstAudioView audio) override;
+    void end() override;
+    size_t get_latency_samples() const override { return DMA_DESC_NUM * DMA_FRAME_NUM; }
+
+    static bool on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
+};
+
+// Runs in the ISR each time the DMA has sent a buffer
+bool IRAM_ATTR AudioOutput::Impl::on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
 {
+    auto impl = static_cast<Impl *>(user_ctx);
+    if (impl->task == nullptr)
+        return false;
+
+    BaseType_t high_task_awoken = pdFALSE;
+    vTaskNotifyGiveFromISR(impl->task, &high_task_awoken);
+    return high_task_awoken == pdTRUE;
 }
 
-bool AudioOutput::play(const AudioData &audio)
+void AudioOutput::Impl::create_channel()
 {
-    const i2s_slot_mode_t slot_mode = static_cast<i2s_slot_mode_t>(audio.get_num_channels());
-    const i2s_data_bit_width_t data_bit_width = static_cast<i2s_data_bit_width_t>(audio.get_bits_per_sample());
+    const i2s_slot_mode_t slot_mode = static_cast<i2s_slot_mode_t>(AUDIO_FORMAT.num_channels);
+    const i2s_data_bit_width_t data_bit_width = static_cast<i2s_data_bit_width_t>(AUDIO_FORMAT.bits_per_sample);
 
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_AUDIO, I2S_ROLE_MASTER);
-    i2s_chan_handle_t tx_handle = 0;
+    chan_cfg.dma_desc_num = DMA_DESC_NUM;
+    chan_cfg.dma_frame_num = DMA_FRAME_NUM;
+    // send silence instead of repeating stale buffers when there is nothing to play
+    chan_cfg.auto_clear = true;
+
     ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &tx_handle, NULL));
 
     const i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(audio.get_sample_rate()),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(AUDIO_FORMAT.sample_rate),
         .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(data_bit_width, slot_mode),
         .gpio_cfg =
             {
@@ -47,16 +84,78 @@ bool AudioOutput::play(const AudioData &audio)
     };
     ESP_ERROR_CHECK(i2s_channel_init_std_mode(tx_handle, &std_cfg));
 
-    size_t bytes_written = 0;
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_sent = on_sent;
+    ESP_ERROR_CHECK(i2s_channel_register_event_callback(tx_handle, &callbacks, this));
+    ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
+}
 
-    // avoid clicks and pops before playing
-    int8_t empty[1];
-    ESP_ERROR_CHECK(i2s_channel_preload_data(tx_handle, empty, 0, &bytes_written));
+void AudioOutput::Impl::begin()
+{
+    // the sink is only used from the playback task
+    task = xTaskGetCurrentTaskHandle();
+}
 
-    ESP_ERROR_CHECK(i2s_channel_enable(tx_handle));
+void AudioOutput::Impl::write(ConstAudioView audio)
+{
+    size_t bytes_written = 0;
     ESP_ERROR_CHECK(i2s_channel_write(tx_handle, audio.get_data(), audio.get_size(), &bytes_written, portMAX_DELAY));
-    ESP_ERROR_CHECK(i2s_channel_disable(tx_handle));
-    ESP_ERROR_CHECK(i2s_del_channel(tx_handle));
+}
 
-    return true;
+void AudioOutput::Impl::end()
+{
+    // the written data is somewhere in the DMA ring, it is out once the DMA
+    // went around the ring once more
+    ulTaskNotifyValueClear(nullptr, UINT32_MAX);
+    for (uint32_t i = 0; i < DMA_DESC_NUM; i++)
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+}
+
+AudioOutput::AudioOutput(std::shared_ptr<EventLoop> event_loop) : m_impl(std::make_unique<Impl>())
+{
+    m_impl->create_channel();
+    m_impl->mixer = std::make_unique<PlaybackMixer>(event_loop, *m_impl, AUDIO_FORMAT, CHUNK_SAMPLES);
+}
+
+AudioOutput::~AudioOutput()
+{
+}
+
+std::shared_ptr<Playback> AudioOutput::play_async(ConstAudioView audio, Playback::Callback on_finished,
+                                                  AudioMixer::Priority priority, Gain gain)
+{
+    // assets are converted to the output format at load time, so the clock
+    // is configured once and never follows the file
+    assert(audio.get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(audio, std::move(on_finished), priority, gain);
+}
+
+std::shared_ptr<Playback> AudioOutput::play_async(std::unique_ptr<WavStream> stream, Playback::Callback on_finished,
+                                                  AudioMixer::Priority priority, Gain gain)
+{
+    assert(stream->get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(std::move(stream), std::move(on_finished), priority, gain);
+}
+
+std::shared_ptr<Playback> AudioOutput::play_async(std::shared_ptr<JitterBuffer> jitter_buffer,
+                                                  Playback::Callback on_finished, AudioMixer::Priority priority,
+                                                  Gain gain)
+{
+    assert(jitter_buffer->get_format() == AUDIO_FORMAT);
+    return m_impl->mixer->push(std::move(jitter_buffer), std::move(on_finished), priority, gain);
+}
+
+void AudioOutput::set_volume(int percent)
+{
+    m_impl->mixer->set_volume(percent);
+}
+
+int AudioOutput::get_volume() const
+{
+    return m_impl->mixer->get_volume();
+}
+
+std::shared_ptr<EchoReference> AudioOutput::get_echo_reference() const
+{
+    return m_impl->mixer->get_echo_reference();
 }
@@ -0,0 +1,45 @@
+#include "capture_conditioning.h"
+
+#include "sound/capture_stages.h"
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+#include <cmath>
+
+static const char *TAG = "capture_conditioning";
+
+// Far below the voice band, only the offset of the microphone goes
+constexpr const float DC_BLOCK_CUTOFF_HZ = 10.0f;
+
+static uint32_t get_cycle_count()
+{
+    return esp_cpu_get_cycle_count();
+}
+
+std::unique_ptr<CapturePipeline> create_capture_pipeline(const AudioFormat &microphone_format)
+{
+    const uint32_t num_channels = microphone_format.num_channels;
+    const uint32_t sample_rate = microphone_format.sample_rate;
+    auto pipeline = std::make_unique<CapturePipeline>(num_channels, get_cycle_count);
+
+#if CONFIG_NOSSAT_CAPTURE_DC_BLOCK
+    pipeline->add_stage(std::make_unique<DcBlockStage>(sample_rate, DC_BLOCK_CUTOFF_HZ));
+#endif
+#if CONFIG_NOSSAT_CAPTURE_HIGH_PASS_HZ > 0
+    pipeline->add_stage(std::make_unique<HighPassStage>(sample_rate, CONFIG_NOSSAT_CAPTURE_HIGH_PASS_HZ));
+#endif
+#if CONFIG_NOSSAT_CAPTURE_GAIN_DB != 0
+    const float gain = std::pow(10.0f, CONFIG_NOSSAT_CAPTURE_GAIN_DB / 20.0f);
+    pipeline->add_stage(std::make_unique<GainStage>(make_gain(gain)));
+#endif
+#if CONFIG_NOSSAT_CAPTURE_SWAP_MICROPHONES
+    if (num_channels >= 2)
+        pipeline->add_stage(std::make_unique<ChannelMapStage>(std::array<uint8_t, MAX_CAPTURE_CHANNELS>{1, 0, 2, 3}));
+#endif
+
+    ESP_LOGI(TAG, "Capture pipeline: %d stages over %d channels", static_cast<int>(pipeline->get_num_stages()),
+             static_cast<int>(num_channels));
+    return pipeline;
+}
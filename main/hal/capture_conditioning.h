@@ -0,0 +1,10 @@
+#pragma once
+
+#include "sound/capture_pipeline.h"
+
+#include <memory>
+
+// Builds the conditioning of the microphone audio from the NOSSAT_CAPTURE_*
+// options, timed in CPU cycles. Processes the microphone channels of the feed
+// audio, which come first, and may have no stages at all.
+std::unique_ptr<CapturePipeline> create_capture_pipeline(const AudioFormat &microphone_format);
@@ -60,11 +60,12 @@ Knob::Knob(std::shared_ptr<EventLoop> event_loop, gpio_num_t s1_gpio_num, gpio_n
     iot_knob_register_cb(m_knob, KNOB_RIGHT, handler_adapter, right_context);
 }
 
-void Knob::set_value(int value)
+void Knob::set_value(int value, bool notify)
 {
     m_value_offset = value;
+    m_last_reported_value = value;
     iot_knob_clear_count_value(m_knob);
-    if (m_on_value_changed != nullptr)
+    if (notify && m_on_value_changed != nullptr)
         m_on_value_changed(get_value());
 }
 
@@ -24,7 +24,8 @@ public:
          gpio_num_t button_gpio_num);
 
     int get_value() const;
-    void set_value(int value);
+    // notify calls the value changed handler
+    void set_value(int value, bool notify = true);
 
     void set_step_value(int value) { m_step_value = value; }
     void set_value_changed_handler(ValueChangedHandler handler) { m_on_value_changed = handler; }
@@ -0,0 +1,275 @@
+#include "playback.h"
+#include "nossat_err.h"
+#include "system/latency_probes.h"
+#include "system/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const char *TAG = "playback";
+
+Playback::Playback(std::shared_ptr<EventLoop> event_loop, ConstAudioView audio, Callback on_finished)
+    : m_event_loop(std::move(event_loop)), m_audio(audio), m_on_finished(std::move(on_finished))
+{
+}
+
+Playback::Playback(std::shared_ptr<EventLoop> event_loop, std::unique_ptr<WavStream> stream, Callback on_finished)
+    : m_event_loop(std::move(event_loop)), m_stream(std::move(stream)), m_on_finished(std::move(on_finished))
+{
+}
+
+Playback::Playback(std::shared_ptr<EventLoop> event_loop, std::shared_ptr<JitterBuffer> jitter_buffer,
+                   Callback on_finished)
+    : m_event_loop(std::move(event_loop)), m_jitter_buffer(std::move(jitter_buffer)),
+      m_on_finished(std::move(on_finished))
+{
+}
+
+bool Playback::is_finished() const
+{
+    const State state = m_state;
+    return state == State::COMPLETED || state == State::CANCELLED;
+}
+
+void Playback::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished_condition.wait(lock, [this] { return is_finished(); });
+}
+
+size_t Playback::read(AudioView audio)
+{
+    if (is_cancelled())
+        return 0;
+
+    if (m_state == State::QUEUED)
+    {
+        m_state = State::PLAYING;
+        LatencyProbes::instance().on_playback_started();
+    }
+    if (m_stream)
+        return m_stream->read(audio);
+    if (m_jitter_buffer)
+        return m_jitter_buffer->read(audio);
+
+    const size_t num_samples = std::min(audio.get_num_samples(), m_audio.get_num_samples() - m_position);
+    const ConstAudioView chunk = m_audio.subview(m_position, num_samples);
+    memcpy(audio.get_data(), chunk.get_data(), chunk.get_size());
+    m_position += num_samples;
+    return num_samples;
+}
+
+void Playback::on_finished()
+{
+    bool completed = false;
+    if (m_stream)
+    {
+        completed = m_stream->is_finished();
+    }
+    else if (m_jitter_buffer)
+    {
+        completed = m_jitter_buffer->is_finished();
+        // stops the download of a cancelled playback
+        m_jitter_buffer->close();
+    }
+    else
+    {
+        completed = m_position == m_audio.get_num_samples();
+    }
+    m_final_state = completed ? State::COMPLETED : State::CANCELLED;
+    m_mixed_out = true;
+}
+
+void Playback::complete()
+{
+    assert(m_mixed_out);
+    finish(m_final_state);
+}
+
+void Playback::finish(State state)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_state = state;
+    }
+    m_finished_condition.notify_all();
+
+    if (m_on_finished)
+    {
+        const bool completed = state == State::COMPLETED;
+        m_event_loop->post([callback = m_on_finished, completed]() { callback(completed); });
+    }
+}
+
+PlaybackMixer::PlaybackMixer(std::shared_ptr<EventLoop> event_loop, ISink &sink, const AudioFormat &format,
+                             size_t chunk_samples, uint32_t sleep_timeout_ms)
+    : m_event_loop(event_loop), m_sink(sink), m_mixer(format, chunk_samples), m_chunk(format, chunk_samples),
+      m_echo_reference(std::make_shared<EchoReference>(format.sample_rate)), m_sleep_timeout_ms(sleep_timeout_ms),
+      m_wakeup(xSemaphoreCreateBinary()),
+      m_latency_chunks((sink.get_latency_samples() + chunk_samples - 1) / chunk_samples),
+      m_streams_wakeup(xSemaphoreCreateBinary())
+{
+    ESP_TRUE_CHECK(m_wakeup);
+    ESP_TRUE_CHECK(m_streams_wakeup);
+    m_streams.reserve(AudioMixer::MAX_NUM_VOICES);
+    // mixed out voices linger for the sink latency next to the active ones
+    m_playing.reserve(2 * AudioMixer::MAX_NUM_VOICES);
+    create_task(std::bind(&PlaybackMixer::run, this), "Audio Output", 3 * 1024, 6, 0);
+    create_task(std::bind(&PlaybackMixer::run_streams, this), "Audio Stream", 4 * 1024, 5, 0);
+}
+
+std::shared_ptr<Playback> PlaybackMixer::push(ConstAudioView audio, Playback::Callback on_finished,
+                                              AudioMixer::Priority priority, Gain gain)
+{
+    return add_voice(std::make_shared<Playback>(m_event_loop, audio, std::move(on_finished)), priority, gain);
+}
+
+std::shared_ptr<Playback> PlaybackMixer::push(std::unique_ptr<WavStream> stream, Playback::Callback on_finished,
+                                              AudioMixer::Priority priority, Gain gain)
+{
+    // the first buffer is decoded by open(), the stream task takes over from there
+    stream->set_on_drained([this]() { xSemaphoreGive(m_streams_wakeup); });
+    // wakes the stream task once more so it releases the stream
+    auto on_stream_finished = [this, on_finished = std::move(on_finished)](bool completed)
+    {
+        xSemaphoreGive(m_streams_wakeup);
+        if (on_finished)
+            on_finished(completed);
+    };
+    auto playback = std::make_shared<Playback>(m_event_loop, std::move(stream), std::move(on_stream_finished));
+    {
+        std::lock_guard<std::mutex> lock(m_streams_mutex);
+        m_streams.push_back(playback);
+    }
+    xSemaphoreGive(m_streams_wakeup);
+    return add_voice(playback, priority, gain);
+}
+
+std::shared_ptr<Playback> PlaybackMixer::push(std::shared_ptr<JitterBuffer> jitter_buffer,
+                                              Playback::Callback on_finished, AudioMixer::Priority priority,
+                                              Gain gain)
+{
+    return add_voice(std::make_shared<Playback>(m_event_loop, std::move(jitter_buffer), std::move(on_finished)),
+                     priority, gain);
+}
+
+std::shared_ptr<Playback> PlaybackMixer::add_voice(std::shared_ptr<Playback> playback, AudioMixer::Priority priority,
+                                                   Gain gain)
+{
+    {
+        // listed before the output task can mix it out, so it is always completed
+        std::lock_guard<std::mutex> lock(m_playing_mutex);
+        m_playing.push_back({.playback = playback, .chunks_left = m_latency_chunks});
+    }
+    if (!m_mixer.add_voice(playback, gain, priority))
+    {
+        ESP_LOGW(TAG, "All voices are busy, audio is dropped");
+        {
+            std::lock_guard<std::mutex> lock(m_playing_mutex);
+            std::erase_if(m_playing, [&playback](const PlayingVoice &voice) { return voice.playback == playback; });
+        }
+        playback->cancel();
+        playback->on_finished();
+        playback->complete();
+        return playback;
+    }
+    xSemaphoreGive(m_wakeup);
+    return playback;
+}
+
+void PlaybackMixer::set_volume(int percent)
+{
+    m_volume = std::clamp(percent, 0, 100);
+    m_mixer.set_master_gain(make_volume_gain(m_volume));
+}
+
+void PlaybackMixer::run()
+{
+    bool active = false;
+    // the sink is asleep or never goes to sleep
+    bool asleep = true;
+    TickType_t idle_since = 0;
+    while (true)
+    {
+        if (m_mixer.get_num_voices() == 0)
+        {
+            if (active)
+            {
+                m_sink.end();
+                complete_played(true);
+                active = false;
+                asleep = m_sleep_timeout_ms == 0;
+                idle_since = xTaskGetTickCount();
+            }
+
+            if (asleep)
+            {
+                xSemaphoreTake(m_wakeup, portMAX_DELAY);
+                continue;
+            }
+
+            // a stale wakeup of the last active period may end the wait early
+            const TickType_t timeout = pdMS_TO_TICKS(m_sleep_timeout_ms);
+            const TickType_t elapsed = xTaskGetTickCount() - idle_since;
+            if (elapsed >= timeout || !xSemaphoreTake(m_wakeup, timeout - elapsed))
+            {
+                if (m_mixer.get_num_voices() == 0)
+                {
+                    m_sink.sleep();
+                    asleep = true;
+                }
+            }
+            continue;
+        }
+
+        if (!active)
+        {
+            m_sink.begin();
+            active = true;
+        }
+        m_mixer.mix(m_chunk);
+        // stamped with the time it is queued, the echo delay estimate covers the output buffering
+        const uint32_t sample_time = EchoReference::get_sample_time(esp_timer_get_time(), m_chunk.get_sample_rate());
+        m_echo_reference->write(m_chunk, sample_time);
+        m_sink.write(m_chunk);
+        complete_played(false);
+    }
+}
+
+void PlaybackMixer::complete_played(bool drained)
+{
+    std::lock_guard<std::mutex> lock(m_playing_mutex);
+    std::erase_if(m_playing,
+                  [drained](PlayingVoice &voice)
+                  {
+                      if (!voice.playback->is_mixed_out())
+                          return false;
+                      if (!drained && voice.chunks_left > 0)
+                      {
+                          voice.chunks_left--;
+                          return false;
+                      }
+                      voice.playback->complete();
+                      return true;
+                  });
+}
+
+void PlaybackMixer::run_streams()
+{
+    while (true)
+    {
+        xSemaphoreTake(m_streams_wakeup, portMAX_DELAY);
+
+        std::lock_guard<std::mutex> lock(m_streams_mutex);
+        for (const auto &playback : m_streams)
+        {
+            if (!playback->is_finished())
+                playback->get_stream()->fill();
+        }
+        std::erase_if(m_streams, [](const auto &playback) { return playback->is_finished(); });
+    }
+}
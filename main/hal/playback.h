@@ -0,0 +1,155 @@
+#pragma once
+
+#include "sound/audio_data.h"
+#include "sound/audio_mixer.h"
+#include "sound/audio_view.h"
+#include "sound/echo_reference.h"
+#include "sound/jitter_buffer.h"
+#include "sound/wav_stream.h"
+#include "system/event_loop.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Handle of an asynchronous playback, it is a voice of the playback mixer.
+// In-memory audio is not copied, it has to stay valid until the playback is
+// finished. A streamed playback owns its stream. A network playback reads from
+// a jitter buffer filled by the download and closes it once finished.
+class Playback : public AudioMixer::ISource
+{
+public:
+    enum class State {
+        QUEUED,
+        PLAYING,
+        COMPLETED,
+        CANCELLED,
+    };
+
+    // Posted to the event loop when the playback is finished, completed is
+    // false if it was cancelled
+    using Callback = std::function<void(bool completed)>;
+
+    Playback(std::shared_ptr<EventLoop> event_loop, ConstAudioView audio, Callback on_finished);
+    Playback(std::shared_ptr<EventLoop> event_loop, std::unique_ptr<WavStream> stream, Callback on_finished);
+    Playback(std::shared_ptr<EventLoop> event_loop, std::shared_ptr<JitterBuffer> jitter_buffer,
+             Callback on_finished);
+
+    // Stops at the next chunk, a queued playback never starts
+    void cancel() { m_cancelled = true; }
+    bool is_cancelled() const { return m_cancelled; }
+
+    State get_state() const { return m_state; }
+    // Finished once its last samples have been played, not just mixed
+    bool is_finished() const;
+    // Blocks until the playback is finished
+    void wait();
+
+    size_t read(AudioView audio) override;
+    // The mixer removed the voice, the playback stays unfinished until complete()
+    void on_finished() override;
+    bool is_mixed_out() const { return m_mixed_out; }
+    // Called once the sink has played the last mixed samples
+    void complete();
+
+    // Null for in-memory audio
+    WavStream *get_stream() const { return m_stream.get(); }
+
+private:
+    void finish(State state);
+
+private:
+    const std::shared_ptr<EventLoop> m_event_loop;
+    const ConstAudioView m_audio;
+    const std::unique_ptr<WavStream> m_stream;
+    const std::shared_ptr<JitterBuffer> m_jitter_buffer;
+    const Callback m_on_finished;
+    size_t m_position = 0;
+
+    std::atomic<State> m_state = State::QUEUED;
+    std::atomic<bool> m_cancelled = false;
+    std::atomic<bool> m_mixed_out = false;
+    State m_final_state = State::CANCELLED;
+    std::mutex m_mutex;
+    std::condition_variable m_finished_condition;
+};
+
+// Mixes the active playbacks on the "Audio Output" task and writes the mix to
+// the sink in chunks, so a new playback starts with the next chunk instead of
+// waiting for the others and a cancel takes effect quickly. Streams are
+// decoded ahead on the "Audio Stream" task so the output never waits for
+// flash. Every mixed chunk is also written to the echo reference. A playback
+// finishes once the sink has played its last chunk.
+class PlaybackMixer
+{
+public:
+    struct ISink
+    {
+        virtual ~ISink() = default;
+        // Called when the first playback starts and when the last one is finished
+        virtual void begin() = 0;
+        virtual void write(ConstAudioView audio) = 0;
+        // Returns once the written audio has been played
+        virtual void end() = 0;
+        // Written audio that may still be queued when write() returns, e.g. the DMA ring
+        virtual size_t get_latency_samples() const = 0;
+        // Called once the output stayed idle for the sleep timeout, e.g. to power down
+        virtual void sleep() {}
+    };
+
+    // A sleep_timeout_ms of 0 never puts the sink to sleep
+    PlaybackMixer(std::shared_ptr<EventLoop> event_loop, ISink &sink, const AudioFormat &format,
+                  size_t chunk_samples, uint32_t sleep_timeout_ms = 0);
+
+    std::shared_ptr<Playback> push(ConstAudioView audio, Playback::Callback on_finished,
+                                   AudioMixer::Priority priority, Gain gain);
+    std::shared_ptr<Playback> push(std::unique_ptr<WavStream> stream, Playback::Callback on_finished,
+                                   AudioMixer::Priority priority, Gain gain);
+    std::shared_ptr<Playback> push(std::shared_ptr<JitterBuffer> jitter_buffer, Playback::Callback on_finished,
+                                   AudioMixer::Priority priority, Gain gain);
+
+    // Master volume of 0-100 %, ramped in with the next chunk
+    void set_volume(int percent);
+    int get_volume() const { return m_volume; }
+
+    const std::shared_ptr<EchoReference> &get_echo_reference() const { return m_echo_reference; }
+
+private:
+    std::shared_ptr<Playback> add_voice(std::shared_ptr<Playback> playback, AudioMixer::Priority priority,
+                                        Gain gain);
+    void run();
+    void run_streams();
+    // Completes the mixed out playbacks the sink has played, all of them once it is drained
+    void complete_played(bool drained);
+
+private:
+    std::shared_ptr<EventLoop> m_event_loop;
+    ISink &m_sink;
+    AudioMixer m_mixer;
+    AudioData m_chunk;
+    const std::shared_ptr<EchoReference> m_echo_reference;
+    const uint32_t m_sleep_timeout_ms;
+    std::atomic<int> m_volume = 100;
+    SemaphoreHandle_t m_wakeup = nullptr;
+
+    struct PlayingVoice
+    {
+        std::shared_ptr<Playback> playback;
+        // chunks to write after the one holding the last samples
+        size_t chunks_left = 0;
+    };
+    // Chunks that push the chunk holding the last samples of a voice out of the sink
+    const size_t m_latency_chunks;
+    std::mutex m_playing_mutex;
+    std::vector<PlayingVoice> m_playing;
+
+    std::mutex m_streams_mutex;
+    std::vector<std::shared_ptr<Playback>> m_streams;
+    SemaphoreHandle_t m_streams_wakeup = nullptr;
+};
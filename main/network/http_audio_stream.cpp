@@ -0,0 +1,175 @@
+#include "http_audio_stream.h"
+#include "sound/audio_convert.h"
+#include "sound/audio_data.h"
+#include "sound/read_stream.h"
+#include "sound/wav_reader.h"
+#include "system/task.h"
+
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+
+static const char *TAG = "http_audio";
+
+// Decoded per step of the download, 20 ms at 16 kHz
+constexpr const size_t DECODE_SAMPLES = 320;
+// Wait of the download while the jitter buffer is full
+constexpr const uint32_t BUFFER_FULL_WAIT_MS = 20;
+constexpr const int HTTP_TIMEOUT_MS = 5000;
+
+// Blocking reads of the body of an HTTP GET response
+class HttpReadStream : public IReadStream
+{
+public:
+    explicit HttpReadStream(const std::string &url);
+    ~HttpReadStream() override;
+
+    HttpReadStream(const HttpReadStream &) = delete;
+    HttpReadStream &operator=(const HttpReadStream &) = delete;
+
+    // Sends the request and reads the response headers
+    bool open();
+
+    size_t read(void *buffer, size_t size) override;
+    bool skip(size_t size) override;
+
+private:
+    esp_http_client_handle_t m_client = nullptr;
+};
+
+HttpReadStream::HttpReadStream(const std::string &url)
+{
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.timeout_ms = HTTP_TIMEOUT_MS;
+    m_client = esp_http_client_init(&config);
+}
+
+HttpReadStream::~HttpReadStream()
+{
+    if (m_client != nullptr)
+    {
+        esp_http_client_close(m_client);
+        esp_http_client_cleanup(m_client);
+    }
+}
+
+bool HttpReadStream::open()
+{
+    if (m_client == nullptr)
+        return false;
+
+    const esp_err_t err = esp_http_client_open(m_client, 0);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to connect: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (esp_http_client_fetch_headers(m_client) < 0)
+    {
+        ESP_LOGE(TAG, "Failed to read the response headers");
+        return false;
+    }
+    const int status = esp_http_client_get_status_code(m_client);
+    if (status != 200)
+    {
+        ESP_LOGE(TAG, "HTTP status %d", status);
+        return false;
+    }
+    return true;
+}
+
+size_t HttpReadStream::read(void *buffer, size_t size)
+{
+    // the client returns what has arrived, the decoders expect full reads until the end
+    char *data = static_cast<char *>(buffer);
+    size_t num_read = 0;
+    while (num_read < size)
+    {
+        const int result = esp_http_client_read(m_client, data + num_read, static_cast<int>(size - num_read));
+        if (result <= 0)
+            break;
+        num_read += result;
+    }
+    return num_read;
+}
+
+bool HttpReadStream::skip(size_t size)
+{
+    char buffer[64];
+    while (size > 0)
+    {
+        const size_t num_read = read(buffer, std::min(size, sizeof(buffer)));
+        if (num_read == 0)
+            return false;
+        size -= num_read;
+    }
+    return true;
+}
+
+static void write_all(JitterBuffer &jitter_buffer, ConstAudioView audio)
+{
+    size_t num_written = 0;
+    while (num_written < audio.get_num_samples() && !jitter_buffer.is_closed())
+    {
+        num_written += jitter_buffer.write(audio.subview(num_written, audio.get_num_samples() - num_written));
+        if (num_written < audio.get_num_samples())
+            vTaskDelay(pdMS_TO_TICKS(BUFFER_FULL_WAIT_MS));
+    }
+}
+
+static void decode(WavReader &reader, JitterBuffer &jitter_buffer)
+{
+    const AudioFormat &format = reader.get_format();
+    const AudioFormat &output_format = jitter_buffer.get_format();
+    if (format.sample_rate != output_format.sample_rate)
+    {
+        ESP_LOGE(TAG, "Sample rate %lu differs from the output", format.sample_rate);
+        return;
+    }
+    if (format.num_channels != output_format.num_channels && format.num_channels != 1)
+    {
+        ESP_LOGE(TAG, "%lu channels can't be mapped to the output", format.num_channels);
+        return;
+    }
+
+    AudioData decoded(format, DECODE_SAMPLES);
+    AudioData converted(output_format, DECODE_SAMPLES);
+    while (!jitter_buffer.is_closed())
+    {
+        const size_t num_samples = reader.read(decoded);
+        const AudioView chunk = converted.view().subview(0, num_samples);
+        convert_samples_upmix(decoded.view().subview(0, num_samples), chunk);
+        write_all(jitter_buffer, chunk);
+        if (num_samples < DECODE_SAMPLES)
+            break;
+    }
+}
+
+static void download(const std::string &url, JitterBuffer &jitter_buffer)
+{
+    ESP_LOGI(TAG, "Stream %s", url.c_str());
+    {
+        HttpReadStream stream(url);
+        WavReader reader;
+        if (!stream.open())
+            ESP_LOGE(TAG, "Failed to open the stream");
+        else if (!reader.open(stream))
+            ESP_LOGE(TAG, "Invalid audio stream: %s", reader.get_error());
+        else
+            decode(reader, jitter_buffer);
+    }
+    jitter_buffer.end_stream();
+    ESP_LOGI(TAG, "Download finished, %d underruns so far, target %d samples",
+             static_cast<int>(jitter_buffer.get_num_underruns()), static_cast<int>(jitter_buffer.get_target_samples()));
+}
+
+std::shared_ptr<JitterBuffer> start_http_audio_stream(const std::string &url, const AudioFormat &output_format)
+{
+    auto jitter_buffer = std::make_shared<JitterBuffer>(output_format);
+    create_task([url, jitter_buffer]() { download(url, *jitter_buffer); }, "HTTP Audio", 6 * 1024, 5, 0);
+    return jitter_buffer;
+}
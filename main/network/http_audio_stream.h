@@ -0,0 +1,15 @@
+#pragma once
+
+#include "sound/audio_view.h"
+#include "sound/jitter_buffer.h"
+
+#include <memory>
+#include <string>
+
+// Plays a WAV served over HTTP, e.g. a Home Assistant TTS response. The
+// download runs on its own task and decodes PCM or IMA ADPCM into the returned
+// jitter buffer, so playback starts while the rest is still downloading. The
+// sample rate has to match the output, mono is duplicated to every output
+// channel. The task ends with the stream or once the buffer is closed, a
+// failed download ends the buffer empty.
+std::shared_ptr<JitterBuffer> start_http_audio_stream(const std::string &url, const AudioFormat &output_format);
@@ -22,7 +22,7 @@ static std::string command_to_event_id(std::string input)
 }
 
 MqttManager::MqttManager(const std::string &device_name)
-    : m_json_this_device_doc(make_device_doc_json(device_name)),
+    : m_device_name(device_name), m_json_this_device_doc(make_device_doc_json(device_name)),
       m_mqtt_remote(device_name, MQTT_HOSTNAME, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD),
       m_ha_bridge(m_mqtt_remote, "foo_node_id", m_json_this_device_doc)
 {
@@ -44,4 +44,15 @@ std::shared_ptr<HaEntityEvent> MqttManager::add_event(const char *name, const ch
     m_ha_events.push_back(ha_event);
 
     return ha_event;
-}
\ No newline at end of file
+}
+
+void MqttManager::publish(const std::string &topic, const std::string &message)
+{
+    m_mqtt_remote.publishMessage(m_device_name + "/" + topic, message);
+}
+
+void MqttManager::subscribe(const std::string &topic, std::function<void(const std::string &message)> handler)
+{
+    m_mqtt_remote.subscribe(m_device_name + "/" + topic,
+                            [handler](const std::string &, const std::string &message) { handler(message); });
+}
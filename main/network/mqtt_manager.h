@@ -4,6 +4,9 @@
 #include <HaBridge.h>
 #include <entities/HaEntityEvent.h>
 
+#include <functional>
+#include <string>
+
 const constexpr std::string VOICE_COMMAND_EVENT_TYPE = "voice_command";
 
 class MqttManager
@@ -14,7 +17,13 @@ public:
 
     std::shared_ptr<HaEntityEvent> add_event(const char *name, const char *id = nullptr);
 
+    // Topics are relative to the device, e.g. "latency" is "<device name>/latency"
+    void publish(const std::string &topic, const std::string &message);
+    // handler runs on the MQTT task
+    void subscribe(const std::string &topic, std::function<void(const std::string &message)> handler);
+
 private:
+    const std::string m_device_name;
     nlohmann::json m_json_this_device_doc;
     MQTTRemote m_mqtt_remote;
     HaBridge m_ha_bridge;
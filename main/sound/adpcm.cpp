@@ -0,0 +1,155 @@
+#include "adpcm.h"
+
+#include <algorithm>
+#include <cassert>
+
+constexpr const size_t HEADER_SIZE = 4;
+// Bytes of one channel in a group of 8 samples
+constexpr const size_t GROUP_SIZE = 4;
+constexpr const size_t SAMPLES_PER_GROUP = 8;
+
+constexpr const int32_t MAX_STEP_INDEX = 88;
+
+static const int16_t STEP_TABLE[MAX_STEP_INDEX + 1] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t INDEX_TABLE[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+// Shared by the encoder and the decoder so both track the same predictor
+static void update_state(AdpcmState &state, uint8_t nibble)
+{
+    const int32_t step = STEP_TABLE[state.step_index];
+    int32_t diff = step >> 3;
+    if (nibble & 4)
+        diff += step;
+    if (nibble & 2)
+        diff += step >> 1;
+    if (nibble & 1)
+        diff += step >> 2;
+
+    state.predictor = std::clamp(state.predictor + ((nibble & 8) ? -diff : diff), -32768, 32767);
+    state.step_index = std::clamp(state.step_index + INDEX_TABLE[nibble], 0, MAX_STEP_INDEX);
+}
+
+static uint8_t encode_sample(AdpcmState &state, int32_t sample)
+{
+    int32_t diff = sample - state.predictor;
+    uint8_t nibble = 0;
+    if (diff < 0)
+    {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int32_t step = STEP_TABLE[state.step_index];
+    for (uint8_t bit = 4; bit > 0; bit >>= 1)
+    {
+        if (diff >= step)
+        {
+            nibble |= bit;
+            diff -= step;
+        }
+        step >>= 1;
+    }
+
+    update_state(state, nibble);
+    return nibble;
+}
+
+size_t get_adpcm_block_size(uint32_t num_channels, size_t samples_per_block)
+{
+    assert(samples_per_block > 0 && (samples_per_block - 1) % SAMPLES_PER_GROUP == 0);
+    return num_channels * (HEADER_SIZE + (samples_per_block - 1) / SAMPLES_PER_GROUP * GROUP_SIZE);
+}
+
+size_t get_adpcm_samples_per_block(uint32_t num_channels, size_t block_size)
+{
+    const size_t header_size = num_channels * HEADER_SIZE;
+    if (block_size < header_size)
+        return 0;
+    return 1 + (block_size - header_size) / (num_channels * GROUP_SIZE) * SAMPLES_PER_GROUP;
+}
+
+void encode_adpcm_block(ConstAudioView audio, AdpcmState *states, uint8_t *block)
+{
+    assert(audio.get_bits_per_sample() == 16);
+
+    const uint32_t num_channels = audio.get_num_channels();
+    const size_t num_groups = (audio.get_num_samples() - 1) / SAMPLES_PER_GROUP;
+    assert(1 + num_groups * SAMPLES_PER_GROUP == audio.get_num_samples());
+    const int16_t *samples = audio.get_data_typed<int16_t>();
+
+    for (uint32_t j = 0; j < num_channels; j++)
+    {
+        // the first sample is stored verbatim and resets the predictor
+        AdpcmState &state = states[j];
+        state.predictor = samples[j];
+        block[0] = static_cast<uint8_t>(state.predictor);
+        block[1] = static_cast<uint8_t>(state.predictor >> 8);
+        block[2] = static_cast<uint8_t>(state.step_index);
+        block[3] = 0;
+        block += HEADER_SIZE;
+    }
+
+    for (size_t group = 0; group < num_groups; group++)
+    {
+        const int16_t *group_samples = samples + (1 + group * SAMPLES_PER_GROUP) * num_channels;
+        for (uint32_t j = 0; j < num_channels; j++)
+        {
+            for (size_t k = 0; k < GROUP_SIZE; k++)
+            {
+                const uint8_t low = encode_sample(states[j], group_samples[(2 * k) * num_channels + j]);
+                const uint8_t high = encode_sample(states[j], group_samples[(2 * k + 1) * num_channels + j]);
+                block[k] = low | (high << 4);
+            }
+            block += GROUP_SIZE;
+        }
+    }
+}
+
+size_t decode_adpcm_block(const uint8_t *block, size_t block_size, AudioView audio)
+{
+    assert(audio.get_bits_per_sample() == 16);
+    assert(audio.get_num_channels() <= ADPCM_MAX_NUM_CHANNELS);
+
+    const uint32_t num_channels = audio.get_num_channels();
+    const size_t num_samples = get_adpcm_samples_per_block(num_channels, block_size);
+    if (num_samples == 0)
+        return 0;
+    assert(num_samples <= audio.get_num_samples());
+
+    int16_t *samples = audio.get_data_typed<int16_t>();
+    AdpcmState states[ADPCM_MAX_NUM_CHANNELS];
+    for (uint32_t j = 0; j < num_channels; j++)
+    {
+        states[j].predictor = static_cast<int16_t>(block[0] | (block[1] << 8));
+        states[j].step_index = std::min<int32_t>(block[2], MAX_STEP_INDEX);
+        samples[j] = static_cast<int16_t>(states[j].predictor);
+        block += HEADER_SIZE;
+    }
+
+    const size_t num_groups = (num_samples - 1) / SAMPLES_PER_GROUP;
+    for (size_t group = 0; group < num_groups; group++)
+    {
+        int16_t *group_samples = samples + (1 + group * SAMPLES_PER_GROUP) * num_channels;
+        for (uint32_t j = 0; j < num_channels; j++)
+        {
+            for (size_t k = 0; k < GROUP_SIZE; k++)
+            {
+                update_state(states[j], block[k] & 0x0F);
+                group_samples[(2 * k) * num_channels + j] = static_cast<int16_t>(states[j].predictor);
+                update_state(states[j], block[k] >> 4);
+                group_samples[(2 * k + 1) * num_channels + j] = static_cast<int16_t>(states[j].predictor);
+            }
+            block += GROUP_SIZE;
+        }
+    }
+
+    return num_samples;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM, 4 bits per 16-bit sample, in the block layout of WAV files
+// (WAVE_FORMAT_IMA_ADPCM). Every block starts with a 4 byte header per channel
+// holding the first sample and the step index, followed by interleaved groups
+// of 4 bytes (8 samples) per channel. Blocks decode independently.
+constexpr const uint32_t ADPCM_BITS_PER_SAMPLE = 4;
+// 256 bytes per channel
+constexpr const size_t ADPCM_SAMPLES_PER_BLOCK = 505;
+constexpr const uint32_t ADPCM_MAX_NUM_CHANNELS = 8;
+
+struct AdpcmState
+{
+    int32_t predictor = 0;
+    int32_t step_index = 0;
+};
+
+size_t get_adpcm_block_size(uint32_t num_channels, size_t samples_per_block);
+// Also gives the number of samples in a truncated last block
+size_t get_adpcm_samples_per_block(uint32_t num_channels, size_t block_size);
+
+// Encodes 16-bit audio into one block, the number of samples must be 1 plus a
+// multiple of 8. states has an entry per channel and carries the step index
+// from block to block.
+void encode_adpcm_block(ConstAudioView audio, AdpcmState *states, uint8_t *block);
+// Decodes a block of block_size bytes into 16-bit audio, returns the number of
+// decoded samples
+size_t decode_adpcm_block(const uint8_t *block, size_t block_size, AudioView audio);
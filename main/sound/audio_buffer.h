@@ -0,0 +1,152 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Statically typed view of interleaved audio with a known sample type and channel
+// count. Loops over it compile to straight-line code without the per-sample
+// bits_per_sample switch of AudioView::get_value. SampleType may be const,
+// float views hold floating point samples.
+template <typename SampleType, uint32_t Channels> class TypedAudioView
+{
+    using ByteType = std::conditional_t<std::is_const_v<SampleType>, const int8_t, int8_t>;
+
+public:
+    using ValueType = std::remove_const_t<SampleType>;
+    static constexpr const uint32_t NUM_CHANNELS = Channels;
+    static constexpr const uint32_t BITS_PER_SAMPLE = sizeof(ValueType) * 8;
+    static constexpr const bool FLOATING_POINT = std::is_floating_point_v<ValueType>;
+
+    static bool is_compatible(const AudioFormat &format)
+    {
+        return format.num_channels == NUM_CHANNELS && format.bits_per_sample == BITS_PER_SAMPLE &&
+               format.floating_point == FLOATING_POINT;
+    }
+
+    TypedAudioView() = default;
+    TypedAudioView(SampleType *data, size_t num_samples, uint32_t sample_rate)
+        : m_data(data), m_num_samples(num_samples), m_sample_rate(sample_rate)
+    {
+    }
+
+    // Conversion from the dynamic view, the format has to match
+    template <typename OtherByteType>
+        requires std::is_convertible_v<OtherByteType *, ByteType *>
+    explicit TypedAudioView(const BasicAudioView<OtherByteType> &audio)
+        : m_data(audio.template get_data_typed<ValueType>()), m_num_samples(audio.get_num_samples()),
+          m_sample_rate(audio.get_sample_rate())
+    {
+        assert(is_compatible(audio.get_format()));
+    }
+
+    // TypedAudioView<T, N> is implicitly convertible to TypedAudioView<const T, N>
+    template <typename OtherSampleType>
+        requires std::is_convertible_v<OtherSampleType *, SampleType *>
+    TypedAudioView(const TypedAudioView<OtherSampleType, Channels> &other)
+        : m_data(other.get_data()), m_num_samples(other.get_num_samples()), m_sample_rate(other.get_sample_rate())
+    {
+    }
+
+    operator BasicAudioView<ByteType>() const
+    {
+        return BasicAudioView<ByteType>(get_format(), reinterpret_cast<ByteType *>(m_data), m_num_samples);
+    }
+
+    SampleType *get_data() const { return m_data; }
+    SampleType &at(size_t sample, uint32_t channel) const { return m_data[sample * NUM_CHANNELS + channel]; }
+    SampleType *get_sample(size_t sample) const { return m_data + sample * NUM_CHANNELS; }
+
+    size_t get_num_samples() const { return m_num_samples; }
+    size_t get_size() const { return m_num_samples * NUM_CHANNELS; }
+    uint32_t get_sample_rate() const { return m_sample_rate; }
+    AudioFormat get_format() const
+    {
+        return AudioFormat{
+            .num_channels = NUM_CHANNELS,
+            .bits_per_sample = BITS_PER_SAMPLE,
+            .sample_rate = m_sample_rate,
+            .floating_point = FLOATING_POINT,
+        };
+    }
+
+private:
+    SampleType *m_data = nullptr;
+    size_t m_num_samples = 0;
+    uint32_t m_sample_rate = 0;
+};
+
+// Owning counterpart of TypedAudioView
+template <typename SampleType, uint32_t Channels> class AudioBuffer
+{
+public:
+    using View = TypedAudioView<SampleType, Channels>;
+    using ConstView = TypedAudioView<const SampleType, Channels>;
+
+    AudioBuffer() = default;
+    AudioBuffer(size_t num_samples, uint32_t sample_rate)
+        : m_data(num_samples * Channels), m_sample_rate(sample_rate)
+    {
+    }
+
+    void resize(size_t num_samples) { m_data.resize(num_samples * Channels); }
+
+    View view() { return View(m_data.data(), get_num_samples(), m_sample_rate); }
+    ConstView view() const { return ConstView(m_data.data(), get_num_samples(), m_sample_rate); }
+    operator View() { return view(); }
+    operator ConstView() const { return view(); }
+    operator AudioView() { return view(); }
+    operator ConstAudioView() const { return view(); }
+
+    size_t get_num_samples() const { return m_data.size() / Channels; }
+    uint32_t get_sample_rate() const { return m_sample_rate; }
+
+private:
+    std::vector<SampleType> m_data;
+    uint32_t m_sample_rate = 0;
+};
+
+// Calls proc with a TypedAudioView matching the runtime format of audio. Used at
+// the edges to move from the dynamic AudioView into typed hot loops. Returns
+// false when the format has no typed counterpart (packed 24 bits or more than
+// 3 channels).
+template <typename ByteType, typename Proc> bool visit_typed(BasicAudioView<ByteType> audio, Proc &&proc)
+{
+    constexpr bool is_const = std::is_const_v<ByteType>;
+    const auto visit_channels = [&audio, &proc]<typename ValueType>()
+    {
+        using SampleType = std::conditional_t<is_const, const ValueType, ValueType>;
+        switch (audio.get_num_channels())
+        {
+        case 1:
+            proc(TypedAudioView<SampleType, 1>(audio));
+            return true;
+        case 2:
+            proc(TypedAudioView<SampleType, 2>(audio));
+            return true;
+        case 3:
+            proc(TypedAudioView<SampleType, 3>(audio));
+            return true;
+        default:
+            return false;
+        }
+    };
+
+    switch (audio.get_bits_per_sample())
+    {
+    case 8:
+        return visit_channels.template operator()<int8_t>();
+    case 16:
+        return visit_channels.template operator()<int16_t>();
+    case 32:
+        if (audio.get_format().floating_point)
+            return visit_channels.template operator()<float>();
+        return visit_channels.template operator()<int32_t>();
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,284 @@
+#include "audio_convert.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+// Packed 24-bit sample, only copied around by expand_channels
+struct Int24
+{
+    int8_t bytes[3];
+};
+
+template <typename ItemType>
+static void expand_channels_impl(ItemType *data, size_t num_samples, size_t old_num_channels, size_t new_num_channels)
+{
+    for (size_t i = num_samples; i-- > 0;)
+    {
+        const size_t new_offset = i * new_num_channels;
+        const size_t old_offset = i * old_num_channels;
+
+        for (size_t j = new_num_channels; j-- > old_num_channels;)
+            data[new_offset + j] = ItemType();
+
+        for (size_t j = old_num_channels; j-- > 0;)
+            data[new_offset + j] = data[old_offset + j];
+    }
+}
+
+void expand_channels(AudioView audio, uint32_t num_packed_channels)
+{
+    assert(num_packed_channels <= audio.get_num_channels());
+    if (num_packed_channels == audio.get_num_channels())
+        return;
+
+    const size_t num_samples = audio.get_num_samples();
+    const size_t num_channels = audio.get_num_channels();
+    switch (audio.get_bits_per_sample())
+    {
+    case 8:
+        expand_channels_impl(audio.get_data_typed<int8_t>(), num_samples, num_packed_channels, num_channels);
+        break;
+    case 16:
+        expand_channels_impl(audio.get_data_typed<int16_t>(), num_samples, num_packed_channels, num_channels);
+        break;
+    case 24:
+        expand_channels_impl(audio.get_data_typed<Int24>(), num_samples, num_packed_channels, num_channels);
+        break;
+    case 32:
+        expand_channels_impl(audio.get_data_typed<int32_t>(), num_samples, num_packed_channels, num_channels);
+        break;
+    default:
+        assert(!"Audio format is not supported");
+        break;
+    }
+}
+
+// A shift below 16 amplifies, the overflow saturates instead of wrapping
+static int16_t narrow_sample(int32_t value, int shift)
+{
+    return static_cast<int16_t>(std::clamp<int32_t>(value >> shift, INT16_MIN, INT16_MAX));
+}
+
+// Channel counts are template parameters so the inner loop is fully unrolled
+template <size_t InputChannels, size_t OutputChannels>
+static void narrow_interleave_impl(const int32_t *__restrict input, int16_t *__restrict output, size_t num_samples,
+                                   int shift)
+{
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        for (size_t j = 0; j < InputChannels; j++)
+            output[i * OutputChannels + j] = narrow_sample(input[i * InputChannels + j], shift);
+        for (size_t j = InputChannels; j < OutputChannels; j++)
+            output[i * OutputChannels + j] = 0;
+    }
+}
+
+static void narrow_interleave_impl(const int32_t *__restrict input, size_t input_channels, int16_t *__restrict output,
+                                   size_t output_channels, size_t num_samples, int shift)
+{
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        for (size_t j = 0; j < input_channels; j++)
+            output[i * output_channels + j] = narrow_sample(input[i * input_channels + j], shift);
+        for (size_t j = input_channels; j < output_channels; j++)
+            output[i * output_channels + j] = 0;
+    }
+}
+
+void narrow_interleave_i32_to_i16(const int32_t *input, uint32_t input_channels, AudioView output, int shift)
+{
+    assert(output.get_bits_per_sample() == 16);
+    assert(input_channels <= output.get_num_channels());
+
+    int16_t *data = output.get_data_typed<int16_t>();
+    const size_t num_samples = output.get_num_samples();
+    const uint32_t output_channels = output.get_num_channels();
+
+    if (input_channels == 2 && output_channels == 2)
+        narrow_interleave_impl<2, 2>(input, data, num_samples, shift);
+    else if (input_channels == 2 && output_channels == 3)
+        narrow_interleave_impl<2, 3>(input, data, num_samples, shift);
+    else
+        narrow_interleave_impl(input, input_channels, data, output_channels, num_samples, shift);
+}
+
+template <size_t InputChannels, size_t OutputChannels>
+static void interleave_impl(const int32_t *__restrict input, int32_t *__restrict output, size_t num_samples)
+{
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        for (size_t j = 0; j < InputChannels; j++)
+            output[i * OutputChannels + j] = input[i * InputChannels + j];
+        for (size_t j = InputChannels; j < OutputChannels; j++)
+            output[i * OutputChannels + j] = 0;
+    }
+}
+
+static void interleave_impl(const int32_t *__restrict input, size_t input_channels, int32_t *__restrict output,
+                            size_t output_channels, size_t num_samples)
+{
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        for (size_t j = 0; j < input_channels; j++)
+            output[i * output_channels + j] = input[i * input_channels + j];
+        for (size_t j = input_channels; j < output_channels; j++)
+            output[i * output_channels + j] = 0;
+    }
+}
+
+void interleave_i32(const int32_t *input, uint32_t input_channels, AudioView output)
+{
+    assert(output.get_bits_per_sample() == 32 && !output.get_format().floating_point);
+    assert(input_channels <= output.get_num_channels());
+
+    int32_t *data = output.get_data_typed<int32_t>();
+    const size_t num_samples = output.get_num_samples();
+    const uint32_t output_channels = output.get_num_channels();
+
+    if (input_channels == output_channels)
+        memcpy(data, input, output.get_size());
+    else if (input_channels == 2 && output_channels == 3)
+        interleave_impl<2, 3>(input, data, num_samples);
+    else
+        interleave_impl(input, input_channels, data, output_channels, num_samples);
+}
+
+// Rounds a Q31 value to the given number of bits, saturating the positive
+// overflow of rounding up
+template <int Bits> static int32_t narrow_q31(int32_t value)
+{
+    constexpr int32_t max = (1 << (Bits - 1)) - 1;
+    return std::min(((value >> (31 - Bits)) + 1) >> 1, max);
+}
+
+// Sample codecs: load a sample as Q31 and store a Q31 value as a sample. SIZE
+// is the size of one channel sample in bytes.
+struct Int8Codec
+{
+    static constexpr const size_t SIZE = 1;
+    static int32_t load(const int8_t *ptr) { return static_cast<int32_t>(static_cast<uint32_t>(*ptr) << 24); }
+    static void store(int8_t *ptr, int32_t value) { *ptr = static_cast<int8_t>(narrow_q31<8>(value)); }
+};
+
+struct Int16Codec
+{
+    static constexpr const size_t SIZE = 2;
+    static int32_t load(const int8_t *ptr)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(*reinterpret_cast<const int16_t *>(ptr)) << 16);
+    }
+    static void store(int8_t *ptr, int32_t value)
+    {
+        *reinterpret_cast<int16_t *>(ptr) = static_cast<int16_t>(narrow_q31<16>(value));
+    }
+};
+
+struct Int24Codec
+{
+    static constexpr const size_t SIZE = 3;
+    static int32_t load(const int8_t *ptr) { return static_cast<int32_t>(static_cast<uint32_t>(load_int24(ptr)) << 8); }
+    static void store(int8_t *ptr, int32_t value) { store_int24(ptr, narrow_q31<24>(value)); }
+};
+
+struct Int32Codec
+{
+    static constexpr const size_t SIZE = 4;
+    static int32_t load(const int8_t *ptr) { return *reinterpret_cast<const int32_t *>(ptr); }
+    static void store(int8_t *ptr, int32_t value) { *reinterpret_cast<int32_t *>(ptr) = value; }
+};
+
+struct FloatCodec
+{
+    static constexpr const size_t SIZE = 4;
+    static int32_t load(const int8_t *ptr) { return float_to_q31(*reinterpret_cast<const float *>(ptr)); }
+    static void store(int8_t *ptr, int32_t value) { *reinterpret_cast<float *>(ptr) = q31_to_float(value); }
+};
+
+// Each pair of codecs is a separate straight loop the compiler can vectorize
+template <typename InputCodec, typename OutputCodec>
+static void convert_samples_impl(const int8_t *__restrict input, int8_t *__restrict output, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        OutputCodec::store(output + i * OutputCodec::SIZE, InputCodec::load(input + i * InputCodec::SIZE));
+}
+
+template <typename Proc> static bool visit_codec(const AudioFormat &format, Proc &&proc)
+{
+    switch (format.bits_per_sample)
+    {
+    case 8:
+        proc(Int8Codec());
+        return true;
+    case 16:
+        proc(Int16Codec());
+        return true;
+    case 24:
+        proc(Int24Codec());
+        return true;
+    case 32:
+        if (format.floating_point)
+            proc(FloatCodec());
+        else
+            proc(Int32Codec());
+        return true;
+    default:
+        return false;
+    }
+}
+
+void convert_samples(ConstAudioView input, AudioView output)
+{
+    assert(input.get_num_channels() == output.get_num_channels());
+    assert(input.get_num_samples() == output.get_num_samples());
+
+    const AudioFormat &input_format = input.get_format();
+    const AudioFormat &output_format = output.get_format();
+    if (input_format.bits_per_sample == output_format.bits_per_sample &&
+        input_format.floating_point == output_format.floating_point)
+    {
+        memcpy(output.get_data(), input.get_data(), input.get_size());
+        return;
+    }
+
+    const size_t size = input.get_num_samples() * input.get_num_channels();
+    bool supported = false;
+    visit_codec(input_format,
+                [&]<typename InputCodec>(InputCodec)
+                {
+                    supported = visit_codec(output_format,
+                                            [&]<typename OutputCodec>(OutputCodec)
+                                            {
+                                                convert_samples_impl<InputCodec, OutputCodec>(
+                                                    input.get_data(), output.get_data(), size);
+                                            });
+                });
+    if (!supported)
+        assert(!"Audio format is not supported");
+}
+
+void convert_samples_upmix(ConstAudioView input, AudioView output)
+{
+    assert(input.get_num_samples() == output.get_num_samples());
+
+    const uint32_t num_channels = output.get_num_channels();
+    if (input.get_num_channels() == num_channels)
+    {
+        convert_samples(input, output);
+        return;
+    }
+
+    // mono: convert into the leading samples of the output, then duplicate back to front
+    assert(input.get_num_channels() == 1);
+    AudioFormat mono_format = output.get_format();
+    mono_format.num_channels = 1;
+    const size_t num_samples = output.get_num_samples();
+    const AudioView mono(mono_format, output.get_data(), num_samples);
+    convert_samples(input, mono);
+    for (size_t i = num_samples; i-- > 0;)
+    {
+        const int32_t value = mono.get_value(i, 0);
+        for (uint32_t j = 0; j < num_channels; j++)
+            output.set_value(i, j, value);
+    }
+}
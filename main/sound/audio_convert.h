@@ -0,0 +1,29 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Spreads samples packed with num_packed_channels at the beginning of the
+// buffer to the channel layout of audio, zero filling the added channels.
+// Works in place, back to front.
+void expand_channels(AudioView audio, uint32_t num_packed_channels);
+
+// Narrows 32-bit samples by an arithmetic right shift, saturating to 16 bits,
+// and writes them into the first input_channels of a wider 16-bit layout in a
+// single pass. The remaining output channels (e.g. AFE reference) are zero filled.
+void narrow_interleave_i32_to_i16(const int32_t *input, uint32_t input_channels, AudioView output, int shift);
+
+// Copies 32-bit samples into the first input_channels of a wider 32-bit layout
+// keeping full precision, the remaining output channels are zero filled.
+void interleave_i32(const int32_t *input, uint32_t input_channels, AudioView output);
+
+// Converts between sample formats of the same channel layout: 8, 16, packed 24
+// and left justified 32-bit integers and float. Goes through a Q31 intermediate,
+// narrowing rounds to nearest and saturates.
+void convert_samples(ConstAudioView input, AudioView output);
+
+// convert_samples for the streaming decoders, mono input is also duplicated to
+// every output channel. The output must not overlap the input.
+void convert_samples_upmix(ConstAudioView input, AudioView output);
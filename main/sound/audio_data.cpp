@@ -1,25 +1,10 @@
 #include "audio_data.h"
-#include <cassert>
+#include "audio_convert.h"
+#include "audio_gain.h"
+#include "wav_reader.h"
 
-struct wav_header_t
-{
-    // The "RIFF" chunk descriptor
-    uint8_t ChunkID[4];
-    int32_t ChunkSize;
-    uint8_t Format[4];
-    // The "fmt" sub-chunk
-    uint8_t Subchunk1ID[4];
-    int32_t Subchunk1Size;
-    int16_t AudioFormat;
-    int16_t NumChannels;
-    int32_t SampleRate;
-    int32_t ByteRate;
-    int16_t BlockAlign;
-    int16_t BitsPerSample;
-    // The "data" sub-chunk
-    uint8_t Subchunk2ID[4];
-    int32_t Subchunk2Size;
-};
+#include <algorithm>
+#include <cassert>
 
 AudioData::AudioData(AudioFormat format, size_t num_samples) : m_format(format)
 {
@@ -30,10 +15,15 @@ AudioData::AudioData(AudioFormat format, std::vector<int8_t> data) : m_format(fo
 {
 }
 
+AudioData::AudioData(ConstAudioView audio)
+    : m_format(audio.get_format()), m_data(audio.get_data(), audio.get_data() + audio.get_size())
+{
+}
+
 size_t AudioData::get_num_samples() const
 {
-    const size_t bytes_per_sample = m_format.bits_per_sample / 8;
-    return m_data.size() / (bytes_per_sample * m_format.num_channels);
+    const size_t sample_size = m_format.get_sample_size();
+    return sample_size != 0 ? m_data.size() / sample_size : 0;
 }
 
 void AudioData::set_format(AudioFormat format, size_t num_samples)
@@ -44,28 +34,11 @@ void AudioData::set_format(AudioFormat format, size_t num_samples)
 
 void AudioData::resize(size_t num_samples)
 {
-    // TODO 24 bits
     const size_t bytes_per_sample = m_format.bits_per_sample / 8;
     const size_t lenght = num_samples * bytes_per_sample * m_format.num_channels;
     m_data.resize(lenght);
 }
 
-template <typename ItemType>
-static void add_channels_impl(ItemType *data, size_t num_samples, size_t old_num_channels, size_t new_num_channels)
-{
-    for (int i = num_samples - 1; i >= 0; i--)
-    {
-        const int new_offset = i * new_num_channels;
-        const int old_offset = i * old_num_channels;
-
-        for (int j = new_num_channels - 1; j >= old_num_channels; j--)
-            data[new_offset + j] = 0;
-
-        for (int j = old_num_channels - 1; j >= 0; j--)
-            data[new_offset + j] = data[old_offset + j];
-    }
-}
-
 void AudioData::add_channels(size_t num)
 {
     const size_t num_samples = get_num_samples();
@@ -73,108 +46,59 @@ void AudioData::add_channels(size_t num)
     m_format.num_channels += num;
     resize(num_samples);
 
-    switch (m_format.bits_per_sample)
-    {
-    case 8:
-        add_channels_impl(get_data_typed<int8_t>(), num_samples, original_num_channels, m_format.num_channels);
-        break;
-    case 16:
-        add_channels_impl(get_data_typed<int16_t>(), num_samples, original_num_channels, m_format.num_channels);
-        break;
-    case 32:
-        add_channels_impl(get_data_typed<int32_t>(), num_samples, original_num_channels, m_format.num_channels);
-        break;
-    default:
-        assert(!"Audio format is not supported");
-        break;
-    }
+    expand_channels(view(), original_num_channels);
 }
 
-AudioData AudioData::load_wav(const std::vector<int8_t> &buffer)
+AudioData AudioData::load_wav(IReadStream &stream)
 {
-    const auto header = reinterpret_cast<const wav_header_t *>(&buffer[0]);
-    const AudioFormat audio_format = {
-        .num_channels = static_cast<uint32_t>(header->NumChannels),
-        .bits_per_sample = static_cast<uint32_t>(header->BitsPerSample),
-        .sample_rate = static_cast<uint32_t>(header->SampleRate),
-    };
-    std::vector<int8_t> data(buffer.begin() + sizeof(wav_header_t), buffer.end());
-    return AudioData(audio_format, std::move(data));
+    WavReader reader;
+    if (!reader.open(stream))
+        return AudioData();
+
+    AudioData audio(reader.get_format(), reader.get_num_samples());
+    audio.resize(reader.read(audio));
+    return audio;
 }
 
-template <typename ItemType> static void adjust_volume_impl(std::vector<int8_t> &buffer, float factor)
+AudioData AudioData::load_wav(const std::vector<int8_t> &buffer)
 {
-    auto typed_buffer = reinterpret_cast<ItemType *>(buffer.data());
-    auto typed_size = buffer.size() / sizeof(ItemType);
+    MemoryReadStream stream(buffer.data(), buffer.size());
+    return load_wav(stream);
+}
 
-    for (size_t i = 0; i < typed_size; i++)
-        typed_buffer[i] = static_cast<ItemType>(typed_buffer[i] * factor);
+ConstAudioView AudioData::view_wav(const std::vector<int8_t> &buffer)
+{
+    MemoryReadStream stream(buffer.data(), buffer.size());
+    WavReader reader;
+    if (!reader.open(stream) || reader.needs_conversion())
+        return ConstAudioView();
+
+    const size_t available_samples = (buffer.data() + buffer.size() - stream.get_position()) /
+                                     reader.get_format().get_sample_size();
+    return ConstAudioView(reader.get_format(), stream.get_position(),
+                          std::min(reader.get_num_samples(), available_samples));
 }
 
 void AudioData::adjust_volume(float factor)
 {
-    switch (m_format.bits_per_sample)
-    {
-    case 8:
-        adjust_volume_impl<int8_t>(m_data, factor);
-        break;
-    case 16:
-        adjust_volume_impl<int16_t>(m_data, factor);
-        break;
-    case 32:
-        adjust_volume_impl<int32_t>(m_data, factor);
-        break;
-    default:
-        assert(!"Audio format is not supported");
-        break;
-    }
+    apply_gain(view(), make_gain(factor));
 }
 
-void AudioData::join(const AudioData &audio)
+void AudioData::join(ConstAudioView audio)
 {
-    assert(m_format == audio.m_format);
-    m_data.insert(m_data.end(), audio.m_data.begin(), audio.m_data.end());
+    if (is_empty())
+        m_format = audio.get_format();
+
+    assert(m_format == audio.get_format());
+    m_data.insert(m_data.end(), audio.get_data(), audio.get_data() + audio.get_size());
 }
 
 int32_t AudioData::get_value(uint32_t sample, uint32_t channel) const
 {
-    const uint32_t bytes_per_sample = (m_format.bits_per_sample / 8);
-    uint32_t offset = sample * bytes_per_sample * m_format.num_channels + bytes_per_sample * channel;
-
-    const int8_t *ptr = m_data.data() + offset;
-    switch (m_format.bits_per_sample)
-    {
-    case 8:
-        return static_cast<int32_t>(*ptr);
-    case 16:
-        return static_cast<int32_t>(*reinterpret_cast<const int16_t *>(ptr));
-    case 32:
-        return *reinterpret_cast<const int32_t *>(ptr);
-    default:
-        assert(!"Audio format is not supported");
-        break;
-    };
+    return view().get_value(sample, channel);
 }
 
 void AudioData::set_value(uint32_t sample, uint32_t channel, int32_t value)
 {
-    const uint32_t bytes_per_sample = (m_format.bits_per_sample / 8);
-    uint32_t offset = sample * bytes_per_sample * m_format.num_channels + bytes_per_sample * channel;
-
-    int8_t *ptr = m_data.data() + offset;
-    switch (m_format.bits_per_sample)
-    {
-    case 8:
-        *ptr = static_cast<int8_t>(value);
-        break;
-    case 16:
-        *reinterpret_cast<int16_t *>(ptr) = static_cast<int16_t>(value);
-        break;
-    case 32:
-        *reinterpret_cast<int32_t *>(ptr) = value;
-        break;
-    default:
-        assert(!"Audio format is not supported");
-        break;
-    };
-}
\ No newline at end of file
+    view().set_value(sample, channel, value);
+}
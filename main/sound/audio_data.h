@@ -1,29 +1,25 @@
 #pragma once
 
+#include "audio_view.h"
+#include "read_stream.h"
+
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
-struct AudioFormat
-{
-    bool operator==(const AudioFormat &other) const
-    {
-        return other.num_channels == num_channels && other.bits_per_sample == bits_per_sample &&
-               other.sample_rate == sample_rate;
-    }
-
-    uint32_t num_channels = 0;
-    uint32_t bits_per_sample = 0;
-    uint32_t sample_rate = 0;
-};
-
 class AudioData
 {
 public:
     AudioData() = default;
     AudioData(AudioFormat format, size_t num_samples);
     AudioData(AudioFormat format, std::vector<int8_t> data);
+    explicit AudioData(ConstAudioView audio);
 
+    // Return empty audio if the stream is not a supported PCM WAV
+    static AudioData load_wav(IReadStream &stream);
     static AudioData load_wav(const std::vector<int8_t> &buffer);
+    // Samples of an in-memory WAV without copying. Empty if the samples need conversion
+    static ConstAudioView view_wav(const std::vector<int8_t> &buffer);
 
     void adjust_volume(float factor);
 
@@ -33,7 +29,12 @@ public:
     template <typename T> const T *get_data_typed() const { return reinterpret_cast<const T *>(get_data()); }
     size_t get_size() const { return m_data.size(); }
     bool is_empty() const { return m_format == AudioFormat(); }
-    void join(const AudioData &data);
+    void join(ConstAudioView audio);
+
+    AudioView view() { return AudioView(m_format, get_data(), get_num_samples()); }
+    ConstAudioView view() const { return ConstAudioView(m_format, get_data(), get_num_samples()); }
+    operator AudioView() { return view(); }
+    operator ConstAudioView() const { return view(); }
 
     int32_t get_value(uint32_t sample, uint32_t channel) const;
     void set_value(uint32_t sample, uint32_t channel, int32_t value);
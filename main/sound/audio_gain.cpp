@@ -0,0 +1,181 @@
+#include "audio_gain.h"
+#include "audio_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+// Gain below which 16-bit samples can be scaled in 32-bit arithmetic
+constexpr const Gain GAIN_MAX_32BIT_PRODUCT = 2 * GAIN_UNITY - 1;
+
+constexpr const int32_t GAIN_ROUNDING = 1 << (GAIN_SHIFT - 1);
+
+// Fractional bits of the interpolated gain in ramps
+constexpr const int RAMP_SHIFT = 16;
+
+constexpr const int64_t INT24_MIN = -(1 << 23);
+constexpr const int64_t INT24_MAX = (1 << 23) - 1;
+
+Gain make_gain(float factor)
+{
+    const float gain = factor * GAIN_UNITY + 0.5f;
+    return static_cast<Gain>(std::clamp(gain, 0.0f, static_cast<float>(GAIN_MAX)));
+}
+
+float gain_to_float(Gain gain)
+{
+    return static_cast<float>(gain) / GAIN_UNITY;
+}
+
+Gain make_volume_gain(int percent)
+{
+    const int32_t clamped = std::clamp(percent, 0, 100);
+    return (clamped * clamped * GAIN_UNITY + 5000) / 10000;
+}
+
+template <typename ItemType, typename AccType> static ItemType saturate(AccType value)
+{
+    constexpr AccType min = std::numeric_limits<ItemType>::min();
+    constexpr AccType max = std::numeric_limits<ItemType>::max();
+    return static_cast<ItemType>(std::clamp(value, min, max));
+}
+
+// Kept branch free and without aliasing so the compiler can vectorize it
+template <typename ItemType, typename AccType>
+static void apply_gain_impl(ItemType *__restrict data, size_t size, Gain gain)
+{
+    const AccType typed_gain = gain;
+    for (size_t i = 0; i < size; i++)
+        data[i] = saturate<ItemType>((data[i] * typed_gain + GAIN_ROUNDING) >> GAIN_SHIFT);
+}
+
+// Attenuation of 16-bit samples: Q15 x Q15 product fits in 32 bits and never
+// saturates, this maps to widening 16-bit multiplies on SIMD targets
+static void attenuate_q15_impl(int16_t *__restrict data, size_t size, Gain gain)
+{
+    const int16_t q15_gain = static_cast<int16_t>(gain);
+    for (size_t i = 0; i < size; i++)
+        data[i] = static_cast<int16_t>((static_cast<int32_t>(data[i]) * q15_gain + GAIN_ROUNDING) >> GAIN_SHIFT);
+}
+
+static void apply_gain_int24_impl(int8_t *data, size_t size, Gain gain)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        int8_t *ptr = data + i * 3;
+        const int64_t value = (static_cast<int64_t>(load_int24(ptr)) * gain + GAIN_ROUNDING) >> GAIN_SHIFT;
+        store_int24(ptr, static_cast<int32_t>(std::clamp(value, INT24_MIN, INT24_MAX)));
+    }
+}
+
+// Float samples are not saturated, they have headroom above full scale
+static void apply_gain_float_impl(float *__restrict data, size_t size, Gain gain)
+{
+    const float float_gain = gain_to_float(gain);
+    for (size_t i = 0; i < size; i++)
+        data[i] *= float_gain;
+}
+
+template <typename View> static void apply_gain_ramp_impl(View audio, Gain from, Gain to)
+{
+    using ItemType = typename View::ValueType;
+
+    const size_t num_samples = audio.get_num_samples();
+    if constexpr (View::FLOATING_POINT)
+    {
+        const float step = (gain_to_float(to) - gain_to_float(from)) / static_cast<float>(num_samples);
+        float gain = gain_to_float(from);
+        for (size_t i = 0; i < num_samples; i++)
+        {
+            ItemType *sample = audio.get_sample(i);
+            for (size_t j = 0; j < View::NUM_CHANNELS; j++)
+                sample[j] *= gain;
+            gain += step;
+        }
+    }
+    else
+    {
+        const int64_t step = (static_cast<int64_t>(to - from) << RAMP_SHIFT) / static_cast<int64_t>(num_samples);
+        int64_t gain = static_cast<int64_t>(from) << RAMP_SHIFT;
+
+        for (size_t i = 0; i < num_samples; i++)
+        {
+            const int64_t sample_gain = gain >> RAMP_SHIFT;
+            ItemType *sample = audio.get_sample(i);
+            for (size_t j = 0; j < View::NUM_CHANNELS; j++)
+                sample[j] = saturate<ItemType>((sample[j] * sample_gain + GAIN_ROUNDING) >> GAIN_SHIFT);
+            gain += step;
+        }
+    }
+}
+
+static void apply_gain_ramp_int24_impl(AudioView audio, Gain from, Gain to)
+{
+    const size_t num_samples = audio.get_num_samples();
+    const int64_t step = (static_cast<int64_t>(to - from) << RAMP_SHIFT) / static_cast<int64_t>(num_samples);
+    int64_t gain = static_cast<int64_t>(from) << RAMP_SHIFT;
+
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        apply_gain_int24_impl(audio.subview(i, 1).get_data(), audio.get_num_channels(), gain >> RAMP_SHIFT);
+        gain += step;
+    }
+}
+
+void apply_gain(AudioView audio, Gain gain)
+{
+    assert(gain >= 0 && gain <= GAIN_MAX);
+    if (gain == GAIN_UNITY)
+        return;
+
+    const size_t size = audio.get_num_samples() * audio.get_num_channels();
+    switch (audio.get_bits_per_sample())
+    {
+    case 8:
+        apply_gain_impl<int8_t, int32_t>(audio.get_data_typed<int8_t>(), size, gain);
+        break;
+    case 16:
+        if (gain < GAIN_UNITY)
+            attenuate_q15_impl(audio.get_data_typed<int16_t>(), size, gain);
+        else if (gain <= GAIN_MAX_32BIT_PRODUCT)
+            apply_gain_impl<int16_t, int32_t>(audio.get_data_typed<int16_t>(), size, gain);
+        else
+            apply_gain_impl<int16_t, int64_t>(audio.get_data_typed<int16_t>(), size, gain);
+        break;
+    case 24:
+        apply_gain_int24_impl(audio.get_data(), size, gain);
+        break;
+    case 32:
+        if (audio.get_format().floating_point)
+            apply_gain_float_impl(audio.get_data_typed<float>(), size, gain);
+        else
+            apply_gain_impl<int32_t, int64_t>(audio.get_data_typed<int32_t>(), size, gain);
+        break;
+    default:
+        assert(!"Audio format is not supported");
+        break;
+    }
+}
+
+void apply_gain_ramp(AudioView audio, Gain from, Gain to)
+{
+    assert(from >= 0 && from <= GAIN_MAX && to >= 0 && to <= GAIN_MAX);
+    if (audio.is_empty())
+        return;
+
+    if (from == to)
+    {
+        apply_gain(audio, to);
+        return;
+    }
+
+    if (audio.get_bits_per_sample() == 24)
+    {
+        apply_gain_ramp_int24_impl(audio, from, to);
+        return;
+    }
+
+    const auto ramp = [from, to](auto typed_audio) { apply_gain_ramp_impl(typed_audio, from, to); };
+    if (!visit_typed(audio, ramp))
+        assert(!"Audio format is not supported");
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <cstdint>
+
+// Gain in Q15 fixed point: GAIN_UNITY is 1.0, values above it boost the signal.
+// 8 and 16 bit samples are processed in 32-bit arithmetic while the gain is
+// below 2.0, 32-bit samples always use a 64-bit intermediate (Q31 samples).
+// Results are saturated to the sample range instead of wrapping.
+using Gain = int32_t;
+
+constexpr const int GAIN_SHIFT = 15;
+constexpr const Gain GAIN_UNITY = 1 << GAIN_SHIFT;
+constexpr const Gain GAIN_MAX = 256 * GAIN_UNITY - 1;
+
+Gain make_gain(float factor);
+float gain_to_float(Gain gain);
+
+// Gain of a volume setting of 0-100 %, on a squared curve so the steps sound even
+Gain make_volume_gain(int percent);
+
+void apply_gain(AudioView audio, Gain gain);
+
+// Linearly ramps the gain from `from` at the first sample towards `to` at the
+// end of the block. All channels of a sample get the same gain.
+void apply_gain_ramp(AudioView audio, Gain from, Gain to);
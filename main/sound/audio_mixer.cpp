@@ -0,0 +1,145 @@
+#include "audio_mixer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+constexpr const int32_t GAIN_ROUNDING = 1 << (GAIN_SHIFT - 1);
+
+// Fractional bits of the interpolated gain in ramps
+constexpr const int RAMP_SHIFT = 16;
+
+// Gains are at most unity so the product of a 16-bit sample and the gain fits in 32 bits
+static void accumulate_impl(int32_t *__restrict accumulator, const int16_t *__restrict data, size_t size, Gain gain)
+{
+    for (size_t i = 0; i < size; i++)
+        accumulator[i] += (data[i] * gain + GAIN_ROUNDING) >> GAIN_SHIFT;
+}
+
+static void accumulate_ramp_impl(int32_t *accumulator, const int16_t *data, size_t num_samples,
+                                 uint32_t num_channels, Gain from, Gain to)
+{
+    const int64_t step = (static_cast<int64_t>(to - from) << RAMP_SHIFT) / static_cast<int64_t>(num_samples);
+    int64_t gain = static_cast<int64_t>(from) << RAMP_SHIFT;
+
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        const int32_t sample_gain = static_cast<int32_t>(gain >> RAMP_SHIFT);
+        for (size_t j = 0; j < num_channels; j++)
+        {
+            const size_t index = i * num_channels + j;
+            accumulator[index] += (data[index] * sample_gain + GAIN_ROUNDING) >> GAIN_SHIFT;
+        }
+        gain += step;
+    }
+}
+
+// Kept branch free so the compiler can vectorize it
+static void saturate_impl(int16_t *__restrict output, const int32_t *__restrict accumulator, size_t size)
+{
+    constexpr int32_t min = std::numeric_limits<int16_t>::min();
+    constexpr int32_t max = std::numeric_limits<int16_t>::max();
+    for (size_t i = 0; i < size; i++)
+        output[i] = static_cast<int16_t>(std::clamp(accumulator[i], min, max));
+}
+
+AudioMixer::AudioMixer(const AudioFormat &format, size_t max_chunk_samples)
+    : m_format(format), m_max_chunk_samples(max_chunk_samples), m_voice_audio(format, max_chunk_samples),
+      m_accumulator(max_chunk_samples * format.num_channels)
+{
+    assert(format.bits_per_sample == 16 && !format.floating_point);
+}
+
+bool AudioMixer::add_voice(std::shared_ptr<ISource> source, Gain gain, Priority priority)
+{
+    assert(source);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto voice =
+        std::find_if(m_voices.begin(), m_voices.end(), [](const Voice &voice) { return !voice.source; });
+    if (voice == m_voices.end())
+        return false;
+
+    voice->source = std::move(source);
+    voice->gain = std::clamp(gain, 0, GAIN_UNITY);
+    voice->priority = priority;
+    // A voice starts at its ducked gain instead of ramping down from full volume
+    voice->current_gain = get_target_gain(*voice, std::max(priority, get_top_priority()), m_master_gain);
+    return true;
+}
+
+size_t AudioMixer::get_num_voices() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::count_if(m_voices.begin(), m_voices.end(), [](const Voice &voice) { return voice.source; });
+}
+
+AudioMixer::Priority AudioMixer::get_top_priority() const
+{
+    Priority top_priority = Priority::MEDIA;
+    for (const Voice &voice : m_voices)
+    {
+        if (voice.source)
+            top_priority = std::max(top_priority, voice.priority);
+    }
+    return top_priority;
+}
+
+Gain AudioMixer::get_target_gain(const Voice &voice, Priority top_priority, Gain master_gain) const
+{
+    Gain gain = voice.gain;
+    if (voice.priority < top_priority)
+        gain = (gain * DUCKING_GAIN + GAIN_ROUNDING) >> GAIN_SHIFT;
+    return (gain * master_gain + GAIN_ROUNDING) >> GAIN_SHIFT;
+}
+
+void AudioMixer::mix(AudioView output)
+{
+    assert(output.get_format() == m_format);
+    assert(output.get_num_samples() <= m_max_chunk_samples);
+
+    const size_t num_samples = output.get_num_samples();
+    const uint32_t num_channels = m_format.num_channels;
+    const size_t size = num_samples * num_channels;
+
+    std::array<std::shared_ptr<ISource>, MAX_NUM_VOICES> finished;
+    size_t num_finished = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::fill_n(m_accumulator.begin(), size, 0);
+        const Priority top_priority = get_top_priority();
+        const Gain master_gain = m_master_gain;
+
+        for (Voice &voice : m_voices)
+        {
+            if (!voice.source)
+                continue;
+
+            const AudioView voice_audio = m_voice_audio.view().subview(0, num_samples);
+            const size_t num_read = voice.source->read(voice_audio);
+            const int16_t *data = voice_audio.get_data_typed<int16_t>();
+
+            const Gain target_gain = get_target_gain(voice, top_priority, master_gain);
+            if (voice.current_gain == target_gain)
+                accumulate_impl(m_accumulator.data(), data, num_read * num_channels, target_gain);
+            else if (num_read > 0)
+                accumulate_ramp_impl(m_accumulator.data(), data, num_read, num_channels, voice.current_gain,
+                                     target_gain);
+            voice.current_gain = target_gain;
+
+            if (num_read < num_samples)
+            {
+                finished[num_finished++] = std::move(voice.source);
+                voice.source = nullptr;
+            }
+        }
+
+        saturate_impl(output.get_data_typed<int16_t>(), m_accumulator.data(), size);
+    }
+
+    // Outside the lock, a finished source may start the next voice
+    for (size_t i = 0; i < num_finished; i++)
+        finished[i]->on_finished();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "audio_data.h"
+#include "audio_gain.h"
+#include "audio_view.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Mixes up to MAX_NUM_VOICES sources of 16-bit audio in saturating fixed
+// point. Every voice has its own gain, up to unity; while a voice of a higher
+// priority is playing the others are ducked. The master gain scales every
+// voice on top, so a volume change costs no extra pass over the mix. Gain
+// changes are ramped over a chunk to avoid clicks. mix() never allocates.
+class AudioMixer
+{
+public:
+    static constexpr const size_t MAX_NUM_VOICES = 4;
+    // Gain of voices below the highest active priority
+    static constexpr const Gain DUCKING_GAIN = GAIN_UNITY / 4;
+
+    enum class Priority {
+        MEDIA,
+        FEEDBACK,
+    };
+
+    struct ISource
+    {
+        virtual ~ISource() = default;
+        // Fills audio in the mixer format, returns the number of samples
+        // read. Fewer samples than requested end the voice.
+        virtual size_t read(AudioView audio) = 0;
+        // Called by mix() once the voice is removed
+        virtual void on_finished() = 0;
+    };
+
+    AudioMixer(const AudioFormat &format, size_t max_chunk_samples);
+
+    // Returns false if all voices are busy
+    bool add_voice(std::shared_ptr<ISource> source, Gain gain = GAIN_UNITY, Priority priority = Priority::MEDIA);
+    size_t get_num_voices() const;
+
+    // Up to unity, takes effect with the next chunk. Thread safe.
+    void set_master_gain(Gain gain) { m_master_gain = std::clamp(gain, 0, GAIN_UNITY); }
+    Gain get_master_gain() const { return m_master_gain; }
+
+    // Fills output with the next chunk of the mix, silence if there are no voices
+    void mix(AudioView output);
+
+    const AudioFormat &get_format() const { return m_format; }
+
+private:
+    struct Voice
+    {
+        std::shared_ptr<ISource> source;
+        Gain gain = GAIN_UNITY;
+        Priority priority = Priority::MEDIA;
+        // gain applied at the end of the previous chunk, including ducking and the master gain
+        Gain current_gain = GAIN_UNITY;
+    };
+
+    Gain get_target_gain(const Voice &voice, Priority top_priority, Gain master_gain) const;
+    Priority get_top_priority() const;
+
+private:
+    const AudioFormat m_format;
+    const size_t m_max_chunk_samples;
+    std::atomic<Gain> m_master_gain = GAIN_UNITY;
+
+    mutable std::mutex m_mutex;
+    std::array<Voice, MAX_NUM_VOICES> m_voices;
+
+    AudioData m_voice_audio;
+    std::vector<int32_t> m_accumulator;
+};
@@ -0,0 +1,376 @@
+#include "audio_recorder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+constexpr const uint16_t WAVE_FORMAT_PCM = 0x0001;
+constexpr const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+constexpr const uint16_t WAVE_FORMAT_IMA_ADPCM = 0x0011;
+
+// RIFF header, fmt chunk with the ADPCM extension, fact chunk and data chunk header
+constexpr const size_t MAX_WAV_HEADER_SIZE = 60;
+
+static int8_t *allocate_buffer(size_t size)
+{
+#ifdef ESP_PLATFORM
+    return static_cast<int8_t *>(heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+#else
+    return static_cast<int8_t *>(malloc(size));
+#endif
+}
+
+static void free_buffer(int8_t *buffer)
+{
+#ifdef ESP_PLATFORM
+    heap_caps_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+// Copies whole samples keeping the leading channels only when the input is wider
+static void copy_samples(int8_t *output, size_t sample_size, const int8_t *data, size_t data_sample_size,
+                         size_t num_samples)
+{
+    if (data_sample_size == sample_size)
+    {
+        memcpy(output, data, num_samples * sample_size);
+    }
+    else
+    {
+        for (size_t i = 0; i < num_samples; i++)
+            memcpy(output + i * sample_size, data + i * data_sample_size, sample_size);
+    }
+}
+
+template <typename T> static uint8_t *put(uint8_t *output, T value)
+{
+    memcpy(output, &value, sizeof(value));
+    return output + sizeof(value);
+}
+
+static uint8_t *put_id(uint8_t *output, const char *id)
+{
+    memcpy(output, id, 4);
+    return output + 4;
+}
+
+// A WAV file made of a header built on the fly and the regions of the
+// recording buffer holding its data
+class RecordingReadStream : public IReadStream
+{
+public:
+    struct Region
+    {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    // block_size is 0 for PCM
+    RecordingReadStream(const AudioFormat &format, size_t block_size, size_t num_samples, Region data,
+                        Region last_block);
+
+    RecordingReadStream(const RecordingReadStream &) = delete;
+    RecordingReadStream &operator=(const RecordingReadStream &) = delete;
+
+    size_t read(void *buffer, size_t size) override;
+    bool skip(size_t size) override;
+
+private:
+    uint8_t m_header[MAX_WAV_HEADER_SIZE];
+    Region m_regions[3];
+    size_t m_size = 0;
+    size_t m_position = 0;
+};
+
+RecordingReadStream::RecordingReadStream(const AudioFormat &format, size_t block_size, size_t num_samples,
+                                         Region data, Region last_block)
+{
+    const size_t data_size = data.size + last_block.size;
+    const uint32_t fmt_size = block_size != 0 ? 20 : 16;
+    const uint32_t header_size = 12 + 8 + fmt_size + (block_size != 0 ? 12 : 0) + 8;
+    assert(header_size <= sizeof(m_header));
+
+    uint8_t *output = put_id(m_header, "RIFF");
+    output = put<uint32_t>(output, header_size - 8 + data_size);
+    output = put_id(output, "WAVE");
+
+    output = put_id(output, "fmt ");
+    output = put<uint32_t>(output, fmt_size);
+    if (block_size != 0)
+    {
+        output = put<uint16_t>(output, WAVE_FORMAT_IMA_ADPCM);
+        output = put<uint16_t>(output, format.num_channels);
+        output = put<uint32_t>(output, format.sample_rate);
+        output = put<uint32_t>(output, format.sample_rate * block_size / ADPCM_SAMPLES_PER_BLOCK);
+        output = put<uint16_t>(output, block_size);
+        output = put<uint16_t>(output, ADPCM_BITS_PER_SAMPLE);
+        // extension of 2 bytes, the samples per block
+        output = put<uint16_t>(output, 2);
+        output = put<uint16_t>(output, ADPCM_SAMPLES_PER_BLOCK);
+
+        // the samples padding the last block are not part of the recording
+        output = put_id(output, "fact");
+        output = put<uint32_t>(output, 4);
+        output = put<uint32_t>(output, num_samples);
+    }
+    else
+    {
+        output = put<uint16_t>(output, format.floating_point ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+        output = put<uint16_t>(output, format.num_channels);
+        output = put<uint32_t>(output, format.sample_rate);
+        output = put<uint32_t>(output, format.sample_rate * format.get_sample_size());
+        output = put<uint16_t>(output, format.get_sample_size());
+        output = put<uint16_t>(output, format.bits_per_sample);
+    }
+
+    output = put_id(output, "data");
+    output = put<uint32_t>(output, data_size);
+    assert(output == m_header + header_size);
+
+    m_regions[0] = {m_header, header_size};
+    m_regions[1] = data;
+    m_regions[2] = last_block;
+    m_size = header_size + data_size;
+}
+
+size_t RecordingReadStream::read(void *buffer, size_t size)
+{
+    auto output = static_cast<uint8_t *>(buffer);
+    size_t num_read = 0;
+    size_t offset = m_position;
+    for (const Region &region : m_regions)
+    {
+        if (offset >= region.size)
+        {
+            offset -= region.size;
+            continue;
+        }
+
+        const size_t num_copied = std::min(size - num_read, region.size - offset);
+        memcpy(output + num_read, region.data + offset, num_copied);
+        num_read += num_copied;
+        offset = 0;
+    }
+
+    m_position += num_read;
+    return num_read;
+}
+
+bool RecordingReadStream::skip(size_t size)
+{
+    if (size > m_size - m_position)
+        return false;
+    m_position += size;
+    return true;
+}
+
+AudioRecorder::AudioRecorder(const AudioFormat &format, size_t max_num_samples, FullPolicy policy,
+                             Encoding encoding)
+    : m_format(format), m_max_num_samples(max_num_samples), m_policy(policy), m_encoding(encoding)
+{
+    assert(m_max_num_samples > 0);
+    if (m_encoding == Encoding::ADPCM)
+    {
+        assert(m_format.bits_per_sample == 16 && m_format.num_channels <= ADPCM_MAX_NUM_CHANNELS);
+        m_block_size = get_adpcm_block_size(m_format.num_channels, ADPCM_SAMPLES_PER_BLOCK);
+        m_max_num_blocks = (m_max_num_samples + ADPCM_SAMPLES_PER_BLOCK - 1) / ADPCM_SAMPLES_PER_BLOCK;
+        m_pending.resize(ADPCM_SAMPLES_PER_BLOCK * m_format.get_sample_size());
+        m_last_block.resize(m_block_size);
+    }
+
+    m_buffer = allocate_buffer(get_buffer_size());
+    assert(m_buffer != nullptr);
+}
+
+AudioRecorder::~AudioRecorder()
+{
+    m_recording = false;
+    wait_for_append();
+    free_buffer(m_buffer);
+}
+
+size_t AudioRecorder::get_buffer_size() const
+{
+    if (m_encoding == Encoding::ADPCM)
+        return m_max_num_blocks * m_block_size;
+    return m_max_num_samples * m_format.get_sample_size();
+}
+
+void AudioRecorder::wait_for_append()
+{
+    while (m_appending > 0)
+        std::this_thread::yield();
+}
+
+void AudioRecorder::start()
+{
+    m_recording = false;
+    wait_for_append();
+
+    m_write_pos = 0;
+    m_num_samples = 0;
+    m_num_dropped_samples = 0;
+    m_num_blocks = 0;
+    m_num_pending_samples = 0;
+    std::fill(std::begin(m_states), std::end(m_states), AdpcmState());
+    m_recording = true;
+}
+
+void AudioRecorder::stop()
+{
+    m_recording = false;
+    wait_for_append();
+
+    linearize();
+    if (m_encoding == Encoding::ADPCM)
+        encode_pending();
+}
+
+std::unique_ptr<IReadStream> AudioRecorder::open_wav_stream(size_t num_samples) const
+{
+    assert(!m_recording && num_samples <= m_num_samples);
+    const auto buffer = reinterpret_cast<const uint8_t *>(m_buffer);
+    if (m_encoding == Encoding::PCM)
+    {
+        return std::make_unique<RecordingReadStream>(
+            m_format, 0, num_samples, RecordingReadStream::Region{buffer, num_samples * m_format.get_sample_size()},
+            RecordingReadStream::Region{});
+    }
+
+    // the last block holds the pending samples, after the blocks of the buffer
+    const size_t num_blocks = (num_samples + ADPCM_SAMPLES_PER_BLOCK - 1) / ADPCM_SAMPLES_PER_BLOCK;
+    const size_t num_buffer_blocks = std::min(num_blocks, m_num_blocks);
+    RecordingReadStream::Region last_block;
+    if (num_blocks > m_num_blocks)
+        last_block = {m_last_block.data(), m_block_size};
+    return std::make_unique<RecordingReadStream>(m_format, m_block_size, num_samples,
+                                                 RecordingReadStream::Region{buffer, num_buffer_blocks * m_block_size},
+                                                 last_block);
+}
+
+void AudioRecorder::append(ConstAudioView audio)
+{
+    assert(audio.get_bits_per_sample() == m_format.bits_per_sample);
+    assert(audio.get_sample_rate() == m_format.sample_rate);
+    assert(audio.get_num_channels() >= m_format.num_channels);
+
+    m_appending++;
+    if (m_recording && m_encoding == Encoding::ADPCM)
+    {
+        append_adpcm(audio.get_data(), audio.get_format().get_sample_size(), audio.get_num_samples());
+    }
+    else if (m_recording)
+    {
+        size_t num_samples = audio.get_num_samples();
+        const int8_t *data = audio.get_data();
+
+        if (m_policy == FullPolicy::STOP)
+        {
+            const size_t num_copied = std::min(num_samples, m_max_num_samples - m_num_samples);
+            m_num_dropped_samples += num_samples - num_copied;
+            num_samples = num_copied;
+        }
+        else if (num_samples > m_max_num_samples)
+        {
+            // only the tail survives anyway
+            const size_t num_skipped = num_samples - m_max_num_samples;
+            data += num_skipped * audio.get_format().get_sample_size();
+            num_samples = m_max_num_samples;
+            m_num_dropped_samples += num_skipped;
+        }
+
+        copy_to_buffer(data, audio.get_format().get_sample_size(), num_samples);
+    }
+    m_appending--;
+}
+
+void AudioRecorder::copy_to_buffer(const int8_t *data, size_t data_sample_size, size_t num_samples)
+{
+    const size_t sample_size = m_format.get_sample_size();
+    while (num_samples > 0)
+    {
+        const size_t num_copied = std::min(num_samples, m_max_num_samples - m_write_pos);
+        copy_samples(m_buffer + m_write_pos * sample_size, sample_size, data, data_sample_size, num_copied);
+
+        data += num_copied * data_sample_size;
+        num_samples -= num_copied;
+        m_write_pos = (m_write_pos + num_copied) % m_max_num_samples;
+        m_num_dropped_samples += std::max(m_num_samples + num_copied, m_max_num_samples) - m_max_num_samples;
+        m_num_samples = std::min(m_num_samples + num_copied, m_max_num_samples);
+    }
+}
+
+void AudioRecorder::append_adpcm(const int8_t *data, size_t data_sample_size, size_t num_samples)
+{
+    const size_t sample_size = m_format.get_sample_size();
+    while (num_samples > 0)
+    {
+        if (m_policy == FullPolicy::STOP && m_num_blocks == m_max_num_blocks)
+        {
+            m_num_dropped_samples += num_samples;
+            break;
+        }
+
+        const size_t num_copied = std::min(num_samples, ADPCM_SAMPLES_PER_BLOCK - m_num_pending_samples);
+        copy_samples(m_pending.data() + m_num_pending_samples * sample_size, sample_size, data, data_sample_size,
+                     num_copied);
+        data += num_copied * data_sample_size;
+        num_samples -= num_copied;
+        m_num_pending_samples += num_copied;
+
+        if (m_num_pending_samples == ADPCM_SAMPLES_PER_BLOCK)
+        {
+            const ConstAudioView block_audio(m_format, m_pending.data(), ADPCM_SAMPLES_PER_BLOCK);
+            encode_adpcm_block(block_audio, m_states, reinterpret_cast<uint8_t *>(m_buffer) + m_write_pos * m_block_size);
+            m_write_pos = (m_write_pos + 1) % m_max_num_blocks;
+            if (m_num_blocks == m_max_num_blocks)
+                m_num_dropped_samples += ADPCM_SAMPLES_PER_BLOCK;
+            else
+                m_num_blocks++;
+            m_num_pending_samples = 0;
+        }
+    }
+
+    m_num_samples = m_num_blocks * ADPCM_SAMPLES_PER_BLOCK + m_num_pending_samples;
+}
+
+void AudioRecorder::linearize()
+{
+    // the oldest sample is at the write position once the buffer has wrapped
+    if (m_encoding == Encoding::ADPCM)
+    {
+        if (m_num_blocks < m_max_num_blocks || m_write_pos == 0)
+            return;
+
+        std::rotate(m_buffer, m_buffer + m_write_pos * m_block_size, m_buffer + m_max_num_blocks * m_block_size);
+        m_write_pos = 0;
+        return;
+    }
+
+    if (m_num_samples < m_max_num_samples || m_write_pos == 0)
+        return;
+
+    const size_t sample_size = m_format.get_sample_size();
+    std::rotate(m_buffer, m_buffer + m_write_pos * sample_size, m_buffer + m_max_num_samples * sample_size);
+    m_write_pos = 0;
+}
+
+void AudioRecorder::encode_pending()
+{
+    if (m_num_pending_samples == 0)
+        return;
+
+    // a whole block keeps the layout of the others, the fact chunk drops the padding
+    const size_t sample_size = m_format.get_sample_size();
+    std::fill(m_pending.begin() + m_num_pending_samples * sample_size, m_pending.end(), 0);
+    const ConstAudioView block_audio(m_format, m_pending.data(), ADPCM_SAMPLES_PER_BLOCK);
+    encode_adpcm_block(block_audio, m_states, m_last_block.data());
+}
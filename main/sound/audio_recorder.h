@@ -0,0 +1,88 @@
+#pragma once
+
+#include "adpcm.h"
+#include "audio_view.h"
+#include "read_stream.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bounded recording buffer preallocated in PSRAM. append() is called from the
+// audio feed task, it never allocates, locks or blocks. With ADPCM encoding
+// 16-bit audio is compressed 4:1 block by block as it is appended. A stopped
+// recording is read back as a WAV stream straight from the buffer, ADPCM is
+// decoded block by block by its reader.
+class AudioRecorder
+{
+public:
+    enum class FullPolicy {
+        OVERWRITE_OLDEST,
+        STOP,
+    };
+
+    enum class Encoding {
+        PCM,
+        ADPCM,
+    };
+
+    AudioRecorder(const AudioFormat &format, size_t max_num_samples, FullPolicy policy,
+                  Encoding encoding = Encoding::PCM);
+    ~AudioRecorder();
+
+    AudioRecorder(const AudioRecorder &) = delete;
+    AudioRecorder &operator=(const AudioRecorder &) = delete;
+
+    void start();
+    // Waits for a pending append to finish and encodes the last incomplete ADPCM block
+    void stop();
+    // Reads the first num_samples of the stopped recording as a WAV file, PCM or
+    // IMA ADPCM as recorded, without copying it. Valid until the next start().
+    std::unique_ptr<IReadStream> open_wav_stream(size_t num_samples) const;
+    // audio may have extra trailing channels (e.g. AFE reference), they are not recorded
+    void append(ConstAudioView audio);
+
+    bool is_recording() const { return m_recording; }
+    const AudioFormat &get_format() const { return m_format; }
+    size_t get_max_num_samples() const { return m_max_num_samples; }
+    size_t get_num_samples() const { return m_num_samples; }
+    size_t get_num_dropped_samples() const { return m_num_dropped_samples; }
+
+    Encoding get_encoding() const { return m_encoding; }
+    // Bytes of the preallocated recording buffer
+    size_t get_buffer_size() const;
+
+private:
+    void wait_for_append();
+    void copy_to_buffer(const int8_t *data, size_t data_sample_size, size_t num_samples);
+    void append_adpcm(const int8_t *data, size_t data_sample_size, size_t num_samples);
+    void linearize();
+    void encode_pending();
+
+private:
+    const AudioFormat m_format;
+    const size_t m_max_num_samples;
+    const FullPolicy m_policy;
+    const Encoding m_encoding;
+    int8_t *m_buffer = nullptr;
+
+    size_t m_write_pos = 0;
+    size_t m_num_samples = 0;
+    size_t m_num_dropped_samples = 0;
+
+    // ADPCM: the ring holds blocks, write position and count are in blocks and
+    // the samples of the block being filled wait in m_pending. stop() encodes
+    // them, padded with silence, into m_last_block.
+    size_t m_block_size = 0;
+    size_t m_max_num_blocks = 0;
+    size_t m_num_blocks = 0;
+    std::vector<int8_t> m_pending;
+    size_t m_num_pending_samples = 0;
+    std::vector<uint8_t> m_last_block;
+    AdpcmState m_states[ADPCM_MAX_NUM_CHANNELS];
+
+    std::atomic<bool> m_recording = false;
+    std::atomic<int> m_appending = 0;
+};
@@ -0,0 +1,154 @@
+#include "audio_resampler.h"
+#include "audio_convert.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+// Fraction of the Nyquist frequency kept by the anti-aliasing filter
+constexpr const double PASSBAND = 0.9;
+
+static double sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    return std::sin(M_PI * x) / (M_PI * x);
+}
+
+static double blackman(double n, double length)
+{
+    return 0.42 - 0.5 * std::cos(2 * M_PI * n / (length - 1)) + 0.08 * std::cos(4 * M_PI * n / (length - 1));
+}
+
+Resampler::Resampler(uint32_t input_rate, uint32_t output_rate, uint32_t taps_per_phase)
+    : m_taps_per_phase(taps_per_phase)
+{
+    assert(input_rate > 0 && output_rate > 0 && taps_per_phase > 0);
+    const uint32_t divisor = std::gcd(input_rate, output_rate);
+    m_interpolation = output_rate / divisor;
+    m_decimation = input_rate / divisor;
+
+    // prototype low pass at the upsampled rate, cut off at the lower Nyquist frequency
+    const size_t length = static_cast<size_t>(m_interpolation) * m_taps_per_phase;
+    const double cutoff = 0.5 * PASSBAND * std::min(1.0, static_cast<double>(m_interpolation) / m_decimation) /
+                          m_interpolation;
+    const double center = (length - 1) / 2.0;
+
+    m_banks.resize(length);
+    for (size_t k = 0; k < length; k++)
+    {
+        const double value = m_interpolation * 2 * cutoff * sinc(2 * cutoff * (k - center)) * blackman(k, length);
+        const size_t phase = k % m_interpolation;
+        const size_t tap = k / m_interpolation;
+        m_banks[phase * m_taps_per_phase + tap] = static_cast<float>(value);
+    }
+}
+
+size_t Resampler::get_num_output_samples(size_t num_input_samples) const
+{
+    return (static_cast<uint64_t>(num_input_samples) * m_interpolation + m_decimation - 1) / m_decimation;
+}
+
+void Resampler::process(const float *input, size_t input_stride, size_t num_input_samples, float *output,
+                        size_t output_stride) const
+{
+    const size_t num_output_samples = get_num_output_samples(num_input_samples);
+    // compensate the group delay of the prototype filter
+    const uint64_t delay = static_cast<uint64_t>(m_interpolation) * m_taps_per_phase / 2;
+
+    for (size_t n = 0; n < num_output_samples; n++)
+    {
+        const uint64_t position = static_cast<uint64_t>(n) * m_decimation + delay;
+        const size_t phase = position % m_interpolation;
+        const int64_t base = static_cast<int64_t>(position / m_interpolation);
+        const float *bank = &m_banks[phase * m_taps_per_phase];
+
+        float sum = 0;
+        for (size_t tap = 0; tap < m_taps_per_phase; tap++)
+        {
+            const int64_t index = base - static_cast<int64_t>(tap);
+            if (index >= 0 && index < static_cast<int64_t>(num_input_samples))
+                sum += bank[tap] * input[index * input_stride];
+        }
+        output[n * output_stride] = sum;
+    }
+}
+
+static float get_normalized(ConstAudioView audio, size_t sample, uint32_t channel)
+{
+    const float scale = static_cast<float>(1u << (audio.get_bits_per_sample() - 1));
+    return static_cast<float>(audio.get_value(sample, channel)) / scale;
+}
+
+static void set_normalized(AudioView audio, size_t sample, uint32_t channel, float value)
+{
+    const double scale = static_cast<double>(1u << (audio.get_bits_per_sample() - 1));
+    const double scaled = std::round(static_cast<double>(value) * scale);
+    audio.set_value(sample, channel, static_cast<int32_t>(std::clamp(scaled, -scale, scale - 1)));
+}
+
+// Mixes audio to num_channels of interleaved normalized floats
+static std::vector<float> mix_channels(ConstAudioView audio, uint32_t num_channels)
+{
+    const size_t num_samples = audio.get_num_samples();
+    const uint32_t input_channels = audio.get_num_channels();
+
+    std::vector<float> output(num_samples * num_channels);
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        float *sample = &output[i * num_channels];
+        if (num_channels == 1 && input_channels > 1)
+        {
+            float sum = 0;
+            for (uint32_t j = 0; j < input_channels; j++)
+                sum += get_normalized(audio, i, j);
+            sample[0] = sum / input_channels;
+        }
+        else
+        {
+            for (uint32_t j = 0; j < num_channels; j++)
+                sample[j] = get_normalized(audio, i, j % input_channels);
+        }
+    }
+    return output;
+}
+
+AudioData convert_audio(ConstAudioView audio, const AudioFormat &format)
+{
+    if (audio.get_format() == format)
+        return AudioData(audio);
+
+    if (audio.get_num_channels() == format.num_channels && audio.get_sample_rate() == format.sample_rate)
+    {
+        // only the sample format differs
+        AudioData output(format, audio.get_num_samples());
+        convert_samples(audio, output);
+        return output;
+    }
+
+    const uint32_t num_channels = format.num_channels;
+    std::vector<float> mixed = mix_channels(audio, num_channels);
+    size_t num_samples = audio.get_num_samples();
+
+    if (audio.get_sample_rate() != format.sample_rate)
+    {
+        const Resampler resampler(audio.get_sample_rate(), format.sample_rate);
+        const size_t num_output_samples = resampler.get_num_output_samples(num_samples);
+
+        std::vector<float> resampled(num_output_samples * num_channels);
+        for (uint32_t j = 0; j < num_channels; j++)
+            resampler.process(&mixed[j], num_channels, num_samples, &resampled[j], num_channels);
+
+        mixed = std::move(resampled);
+        num_samples = num_output_samples;
+    }
+
+    AudioData output(format, num_samples);
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        for (uint32_t j = 0; j < num_channels; j++)
+            set_normalized(output, i, j, mixed[i * num_channels + j]);
+    }
+    return output;
+}
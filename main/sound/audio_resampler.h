@@ -0,0 +1,36 @@
+#pragma once
+
+#include "audio_data.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Polyphase FIR sample rate converter for a rational ratio output_rate / input_rate.
+// Meant for load-time conversion of assets, it works in float.
+class Resampler
+{
+public:
+    static constexpr const uint32_t DEFAULT_TAPS_PER_PHASE = 24;
+
+    Resampler(uint32_t input_rate, uint32_t output_rate, uint32_t taps_per_phase = DEFAULT_TAPS_PER_PHASE);
+
+    size_t get_num_output_samples(size_t num_input_samples) const;
+
+    // Resamples one channel of interleaved data, strides are in items
+    void process(const float *input, size_t input_stride, size_t num_input_samples, float *output,
+                 size_t output_stride) const;
+
+private:
+    uint32_t m_interpolation = 1;
+    uint32_t m_decimation = 1;
+    uint32_t m_taps_per_phase = 0;
+    // m_interpolation banks of m_taps_per_phase coefficients
+    std::vector<float> m_banks;
+};
+
+// Converts audio to the given format: channel up/down-mix, sample rate and bit depth.
+// Mono is duplicated to every output channel, downmix to mono averages all channels,
+// any other change keeps the leading channels and repeats them cyclically. A change
+// of the sample format alone goes through convert_samples.
+AudioData convert_audio(ConstAudioView audio, const AudioFormat &format);
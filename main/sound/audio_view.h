@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Integer samples are signed and little endian: 8, 16, packed 24 or 32 bits.
+// 32-bit integer samples are left justified (Q31), e.g. 24 valid bits from
+// an I2S microphone keep their position. Floating point samples are 32-bit
+// floats in the [-1.0, 1.0) range.
+struct AudioFormat
+{
+    bool operator==(const AudioFormat &other) const
+    {
+        return other.num_channels == num_channels && other.bits_per_sample == bits_per_sample &&
+               other.sample_rate == sample_rate && other.floating_point == floating_point;
+    }
+
+    // Size of one sample of all channels in bytes
+    uint32_t get_sample_size() const { return bits_per_sample / 8 * num_channels; }
+
+    uint32_t num_channels = 0;
+    uint32_t bits_per_sample = 0;
+    uint32_t sample_rate = 0;
+    bool floating_point = false;
+};
+
+inline int32_t load_int24(const int8_t *ptr)
+{
+    const auto bytes = reinterpret_cast<const uint8_t *>(ptr);
+    const uint32_t value = (bytes[0] << 8) | (bytes[1] << 16) | (static_cast<uint32_t>(bytes[2]) << 24);
+    return static_cast<int32_t>(value) >> 8;
+}
+
+inline void store_int24(int8_t *ptr, int32_t value)
+{
+    ptr[0] = static_cast<int8_t>(value);
+    ptr[1] = static_cast<int8_t>(value >> 8);
+    ptr[2] = static_cast<int8_t>(value >> 16);
+}
+
+// Branch free so conversion loops vectorize, the upper bound is the largest
+// float below 2^31
+inline int32_t float_to_q31(float value)
+{
+    const float scaled = value * 2147483648.0f;
+    return static_cast<int32_t>(std::min(std::max(scaled, -2147483648.0f), 2147483520.0f));
+}
+
+inline float q31_to_float(int32_t value)
+{
+    return static_cast<float>(value) * (1.0f / 2147483648.0f);
+}
+
+// Non-owning reference to interleaved audio samples. Passed by value through the
+// capture and playback paths instead of AudioData to avoid copying sample data.
+template <typename ByteType> class BasicAudioView
+{
+    template <typename T> using Typed = std::conditional_t<std::is_const_v<ByteType>, const T, T>;
+
+public:
+    BasicAudioView() = default;
+    BasicAudioView(const AudioFormat &format, ByteType *data, size_t num_samples)
+        : m_format(format), m_data(data), m_num_samples(num_samples)
+    {
+    }
+
+    // AudioView is implicitly convertible to ConstAudioView
+    template <typename OtherByteType>
+        requires std::is_convertible_v<OtherByteType *, ByteType *>
+    BasicAudioView(const BasicAudioView<OtherByteType> &other)
+        : m_format(other.get_format()), m_data(other.get_data()), m_num_samples(other.get_num_samples())
+    {
+    }
+
+    ByteType *get_data() const { return m_data; }
+    template <typename T> Typed<T> *get_data_typed() const { return reinterpret_cast<Typed<T> *>(m_data); }
+    size_t get_size() const { return m_num_samples * m_format.get_sample_size(); }
+    bool is_empty() const { return m_num_samples == 0; }
+
+    const AudioFormat &get_format() const { return m_format; }
+    uint32_t get_num_channels() const { return m_format.num_channels; }
+    uint32_t get_bits_per_sample() const { return m_format.bits_per_sample; }
+    uint32_t get_sample_rate() const { return m_format.sample_rate; }
+    size_t get_num_samples() const { return m_num_samples; }
+
+    BasicAudioView subview(size_t first_sample, size_t num_samples) const
+    {
+        assert(first_sample + num_samples <= m_num_samples);
+        return BasicAudioView(m_format, m_data + first_sample * m_format.get_sample_size(), num_samples);
+    }
+
+    // Floating point samples are returned as Q31
+    int32_t get_value(uint32_t sample, uint32_t channel) const
+    {
+        const ByteType *ptr = get_value_ptr(sample, channel);
+        switch (m_format.bits_per_sample)
+        {
+        case 8:
+            return static_cast<int32_t>(*ptr);
+        case 16:
+            return static_cast<int32_t>(*reinterpret_cast<const int16_t *>(ptr));
+        case 24:
+            return load_int24(ptr);
+        case 32:
+            if (m_format.floating_point)
+                return float_to_q31(*reinterpret_cast<const float *>(ptr));
+            return *reinterpret_cast<const int32_t *>(ptr);
+        default:
+            assert(!"Audio format is not supported");
+            return 0;
+        };
+    }
+
+    // Floating point samples are set from Q31
+    void set_value(uint32_t sample, uint32_t channel, int32_t value) const
+    {
+        static_assert(!std::is_const_v<ByteType>, "Audio view is read-only");
+
+        ByteType *ptr = get_value_ptr(sample, channel);
+        switch (m_format.bits_per_sample)
+        {
+        case 8:
+            *ptr = static_cast<int8_t>(value);
+            break;
+        case 16:
+            *reinterpret_cast<int16_t *>(ptr) = static_cast<int16_t>(value);
+            break;
+        case 24:
+            store_int24(ptr, value);
+            break;
+        case 32:
+            if (m_format.floating_point)
+                *reinterpret_cast<float *>(ptr) = q31_to_float(value);
+            else
+                *reinterpret_cast<int32_t *>(ptr) = value;
+            break;
+        default:
+            assert(!"Audio format is not supported");
+            break;
+        };
+    }
+
+private:
+    ByteType *get_value_ptr(uint32_t sample, uint32_t channel) const
+    {
+        const uint32_t bytes_per_sample = m_format.bits_per_sample / 8;
+        return m_data + sample * bytes_per_sample * m_format.num_channels + bytes_per_sample * channel;
+    }
+
+private:
+    AudioFormat m_format;
+    ByteType *m_data = nullptr;
+    size_t m_num_samples = 0;
+};
+
+using AudioView = BasicAudioView<int8_t>;
+using ConstAudioView = BasicAudioView<const int8_t>;
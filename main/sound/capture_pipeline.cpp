@@ -0,0 +1,63 @@
+#include "capture_pipeline.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+// The average follows a change in cost within a few dozen chunks
+constexpr const uint32_t AVERAGE_SHIFT = 4;
+
+CapturePipeline::CapturePipeline(uint32_t num_channels, CycleCounter cycle_counter)
+    : m_num_channels(num_channels), m_cycle_counter(cycle_counter)
+{
+    assert(num_channels > 0 && cycle_counter != nullptr);
+}
+
+void CapturePipeline::add_stage(std::unique_ptr<Stage> stage)
+{
+    auto entry = std::make_unique<StageEntry>();
+    entry->stage = std::move(stage);
+    m_stages.push_back(std::move(entry));
+}
+
+void CapturePipeline::process(AudioView audio)
+{
+    assert((audio.get_bits_per_sample() == 16 || audio.get_bits_per_sample() == 32) &&
+           !audio.get_format().floating_point);
+    assert(audio.get_num_channels() >= m_num_channels);
+
+    m_chunk_samples.store(audio.get_num_samples(), std::memory_order_relaxed);
+    for (const auto &entry : m_stages)
+    {
+        const uint32_t start = m_cycle_counter();
+        entry->stage->process(audio, m_num_channels);
+        // wraps around correctly as long as a stage takes less than a full counter period
+        const uint32_t cycles = m_cycle_counter() - start;
+
+        // only this task writes, the atomics let any task read
+        const uint32_t average = entry->average_cycles.load(std::memory_order_relaxed);
+        const int64_t delta = static_cast<int64_t>(cycles) - average;
+        entry->average_cycles.store(static_cast<uint32_t>(average + (delta >> AVERAGE_SHIFT)),
+                                    std::memory_order_relaxed);
+        if (cycles > entry->max_cycles.load(std::memory_order_relaxed))
+            entry->max_cycles.store(cycles, std::memory_order_relaxed);
+    }
+}
+
+std::string CapturePipeline::get_report() const
+{
+    const uint32_t chunk_samples = std::max<uint32_t>(m_chunk_samples.load(std::memory_order_relaxed), 1);
+
+    std::string report;
+    char line[96];
+    for (const auto &entry : m_stages)
+    {
+        const uint32_t average = entry->average_cycles.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), "%s: avg %lu, max %lu cycles per %lu samples, %lu per sample\n",
+                 entry->stage->get_name(), static_cast<unsigned long>(average),
+                 static_cast<unsigned long>(entry->max_cycles.load(std::memory_order_relaxed)),
+                 static_cast<unsigned long>(chunk_samples), static_cast<unsigned long>(average / chunk_samples));
+        report += line;
+    }
+    return report;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Conditions captured 16-bit or left justified 32-bit audio in place, stage
+// after stage, between the capture and its consumers. Only the first num_channels are processed, the
+// channels after them (e.g. AFE reference) are left alone. The cost of every
+// stage is measured with the cycle counter given, and may be read from any
+// task. Stages are added before the first process(), which never allocates.
+class CapturePipeline
+{
+public:
+    // Free running counter, e.g. the CPU cycle count
+    using CycleCounter = uint32_t (*)();
+
+    class Stage
+    {
+    public:
+        virtual ~Stage() = default;
+        virtual const char *get_name() const = 0;
+        // audio holds at least num_channels channels of 16 or 32-bit samples
+        virtual void process(AudioView audio, uint32_t num_channels) = 0;
+    };
+
+    CapturePipeline(uint32_t num_channels, CycleCounter cycle_counter);
+
+    void add_stage(std::unique_ptr<Stage> stage);
+    size_t get_num_stages() const { return m_stages.size(); }
+
+    void process(AudioView audio);
+
+    // One line per stage: average and max cycles per chunk, and per sample
+    std::string get_report() const;
+
+private:
+    struct StageEntry
+    {
+        std::unique_ptr<Stage> stage;
+        // moving average over the last chunks, in cycles
+        std::atomic<uint32_t> average_cycles = 0;
+        std::atomic<uint32_t> max_cycles = 0;
+    };
+
+    const uint32_t m_num_channels;
+    const CycleCounter m_cycle_counter;
+    std::vector<std::unique_ptr<StageEntry>> m_stages;
+    std::atomic<uint32_t> m_chunk_samples = 0;
+};
@@ -0,0 +1,30 @@
+#include "capture_ring.h"
+
+#include <cassert>
+#include <cstring>
+
+CaptureRing::CaptureRing(const AudioFormat &format, size_t frame_samples, size_t num_frames)
+    : m_format(format), m_frame_samples(frame_samples), m_frames(num_frames),
+      m_data(format, frame_samples * m_frames.get_capacity())
+{
+    assert(frame_samples > 0);
+
+    // every slot points at its own part of the storage for good
+    for (size_t i = 0; i < m_frames.get_capacity(); i++)
+        m_frames.get_slot(i).audio = m_data.view().subview(i * frame_samples, frame_samples);
+}
+
+bool CaptureRing::push(const void *data, int64_t time_us)
+{
+    const uint32_t sequence = m_next_sequence++;
+    Frame *frame = m_frames.begin_push();
+    if (frame == nullptr)
+        return false;
+
+    const size_t frame_size = m_frame_samples * m_format.get_sample_size();
+    memcpy(m_data.get_data() + m_frames.get_slot_index(frame) * frame_size, data, frame_size);
+    frame->time_us = time_us;
+    frame->sequence = sequence;
+    m_frames.end_push();
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "audio_data.h"
+#include "audio_view.h"
+#include "spsc_ring.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size frames of captured audio between the capture DMA and one
+// consumer task, in an SpscRing that drops the frames it has no room for.
+// Every frame carries its sequence number and capture time, so a slow
+// consumer knows exactly what it lost and when the audio it has was
+// captured.
+class CaptureRing
+{
+public:
+    struct Frame
+    {
+        ConstAudioView audio;
+        // Time the last sample of the frame was captured at
+        int64_t time_us = 0;
+        // Counts every captured frame, including the dropped ones
+        uint32_t sequence = 0;
+    };
+
+    // num_frames is rounded up to a power of two
+    CaptureRing(const AudioFormat &format, size_t frame_samples, size_t num_frames);
+
+    // Producer: copies one frame of get_frame_samples(), returns false if the
+    // ring was full and the frame is dropped
+    bool push(const void *data, int64_t time_us);
+
+    // Consumer: the oldest frame, null if the ring is empty. It stays valid
+    // until pop().
+    const Frame *front() const { return m_frames.front(); }
+    void pop() { m_frames.pop(); }
+
+    size_t get_num_frames() const { return m_frames.size(); }
+    size_t get_num_dropped_frames() const { return m_frames.get_num_dropped(); }
+    size_t get_capacity() const { return m_frames.get_capacity(); }
+    size_t get_frame_samples() const { return m_frame_samples; }
+    const AudioFormat &get_format() const { return m_format; }
+
+private:
+    const AudioFormat m_format;
+    const size_t m_frame_samples;
+
+    SpscRing<Frame> m_frames;
+    AudioData m_data;
+
+    // Producer side
+    uint32_t m_next_sequence = 0;
+};
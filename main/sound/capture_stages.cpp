@@ -0,0 +1,142 @@
+#include "capture_stages.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+// Calls process with a value of the sample type of audio, int16_t or int32_t
+template <typename Process> static void visit_sample_type(const AudioView &audio, Process &&process)
+{
+    if (audio.get_bits_per_sample() == 32)
+        process(int32_t());
+    else
+        process(int16_t());
+}
+
+template <typename T> static T saturate_sample(float value)
+{
+    // the largest float below 2^31, the 32-bit maximum itself rounds up out of range
+    constexpr float max = sizeof(T) == 4 ? 2147483520.0f : std::numeric_limits<T>::max();
+    // rounds half away from zero, lrintf is a library call where errno is kept
+    const float clamped = std::clamp(value, static_cast<float>(std::numeric_limits<T>::min()), max);
+    return static_cast<T>(clamped + (clamped < 0 ? -0.5f : 0.5f));
+}
+
+// Every stage runs channel after channel over the interleaved frame, so the
+// recursive state of a channel stays in registers for the whole chunk
+template <typename T, typename Process>
+static void for_each_channel(AudioView audio, uint32_t num_channels, Process process)
+{
+    assert(num_channels <= audio.get_num_channels() && num_channels <= MAX_CAPTURE_CHANNELS);
+    T *data = audio.get_data_typed<T>();
+    const size_t stride = audio.get_num_channels();
+    const size_t size = audio.get_num_samples() * stride;
+    for (uint32_t channel = 0; channel < num_channels; channel++)
+        process(channel, data + channel, data + size, stride);
+}
+
+DcBlockStage::DcBlockStage(uint32_t sample_rate, float cutoff_hz)
+    : m_pole(1.0f - 2.0f * std::numbers::pi_v<float> * cutoff_hz / sample_rate)
+{
+    assert(cutoff_hz > 0 && m_pole > 0);
+}
+
+void DcBlockStage::process(AudioView audio, uint32_t num_channels)
+{
+    const float pole = m_pole;
+    visit_sample_type(audio, [&]<typename T>(T) {
+        for_each_channel<T>(audio, num_channels, [&](uint32_t channel, T *begin, T *end, size_t stride) {
+            State state = m_states[channel];
+            for (T *sample = begin; sample < end; sample += stride)
+            {
+                const float x = *sample;
+                state.y1 = x - state.x1 + pole * state.y1;
+                state.x1 = x;
+                *sample = saturate_sample<T>(state.y1);
+            }
+            m_states[channel] = state;
+        });
+    });
+}
+
+HighPassStage::HighPassStage(uint32_t sample_rate, float cutoff_hz)
+{
+    assert(cutoff_hz > 0 && cutoff_hz < sample_rate / 2.0f);
+    const float w0 = 2.0f * std::numbers::pi_v<float> * cutoff_hz / sample_rate;
+    const float cos_w0 = std::cos(w0);
+    // alpha = sin(w0) / 2Q with the Butterworth Q of 1/sqrt(2)
+    const float alpha = std::sin(w0) / std::numbers::sqrt2_v<float>;
+    const float a0 = 1.0f + alpha;
+    m_b0 = (1.0f + cos_w0) / 2.0f / a0;
+    m_b1 = -(1.0f + cos_w0) / a0;
+    m_b2 = m_b0;
+    m_a1 = -2.0f * cos_w0 / a0;
+    m_a2 = (1.0f - alpha) / a0;
+}
+
+void HighPassStage::process(AudioView audio, uint32_t num_channels)
+{
+    const float b0 = m_b0, b1 = m_b1, b2 = m_b2, a1 = m_a1, a2 = m_a2;
+    visit_sample_type(audio, [&]<typename T>(T) {
+        for_each_channel<T>(audio, num_channels, [&](uint32_t channel, T *begin, T *end, size_t stride) {
+            State state = m_states[channel];
+            for (T *sample = begin; sample < end; sample += stride)
+            {
+                const float x = *sample;
+                const float y = b0 * x + state.z1;
+                state.z1 = b1 * x - a1 * y + state.z2;
+                state.z2 = b2 * x - a2 * y;
+                *sample = saturate_sample<T>(y);
+            }
+            m_states[channel] = state;
+        });
+    });
+}
+
+GainStage::GainStage(Gain gain) : m_gain(gain)
+{
+}
+
+void GainStage::process(AudioView audio, uint32_t num_channels)
+{
+    // without untouched channels the vectorized gain of the mixer applies
+    if (num_channels == audio.get_num_channels())
+    {
+        apply_gain(audio, m_gain);
+        return;
+    }
+
+    const int64_t gain = m_gain;
+    visit_sample_type(audio, [&]<typename T>(T) {
+        for_each_channel<T>(audio, num_channels, [&](uint32_t, T *begin, T *end, size_t stride) {
+            for (T *sample = begin; sample < end; sample += stride)
+            {
+                const int64_t value = (*sample * gain + (1 << (GAIN_SHIFT - 1))) >> GAIN_SHIFT;
+                *sample = static_cast<T>(
+                    std::clamp<int64_t>(value, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+            }
+        });
+    });
+}
+
+ChannelMapStage::ChannelMapStage(const std::array<uint8_t, MAX_CAPTURE_CHANNELS> &map) : m_map(map)
+{
+}
+
+void ChannelMapStage::process(AudioView audio, uint32_t num_channels)
+{
+    assert(num_channels <= audio.get_num_channels() && num_channels <= MAX_CAPTURE_CHANNELS);
+    visit_sample_type(audio, [&]<typename T>(T) {
+        T *data = audio.get_data_typed<T>();
+        const size_t stride = audio.get_num_channels();
+        for (size_t i = 0; i < audio.get_num_samples(); i++, data += stride)
+        {
+            T input[MAX_CAPTURE_CHANNELS];
+            std::copy(data, data + num_channels, input);
+            for (uint32_t channel = 0; channel < num_channels; channel++)
+                data[channel] = input[m_map[channel] < num_channels ? m_map[channel] : channel];
+        }
+    });
+}
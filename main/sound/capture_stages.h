@@ -0,0 +1,86 @@
+#pragma once
+
+#include "audio_gain.h"
+#include "capture_pipeline.h"
+
+#include <array>
+#include <cstdint>
+
+// Stages of the capture pipeline. Each keeps its own state per channel, for
+// up to MAX_CAPTURE_CHANNELS processed channels. A pipeline processes 32-bit
+// audio with the headroom of the microphone before it is narrowed, or 16-bit
+// audio where the input is no wider.
+constexpr const uint32_t MAX_CAPTURE_CHANNELS = 4;
+
+// One-pole DC blocker, y[n] = x[n] - x[n-1] + r * y[n-1], removes the offset
+// of MEMS microphones with a corner far below speech
+class DcBlockStage : public CapturePipeline::Stage
+{
+public:
+    DcBlockStage(uint32_t sample_rate, float cutoff_hz);
+
+    const char *get_name() const override { return "dc_block"; }
+    void process(AudioView audio, uint32_t num_channels) override;
+
+private:
+    struct State
+    {
+        float x1 = 0;
+        float y1 = 0;
+    };
+
+    const float m_pole;
+    std::array<State, MAX_CAPTURE_CHANNELS> m_states{};
+};
+
+// Second-order Butterworth high-pass (RBJ cookbook) in transposed direct
+// form II, cuts the rumble of fans and fridges below the voice band
+class HighPassStage : public CapturePipeline::Stage
+{
+public:
+    HighPassStage(uint32_t sample_rate, float cutoff_hz);
+
+    const char *get_name() const override { return "high_pass"; }
+    void process(AudioView audio, uint32_t num_channels) override;
+
+private:
+    struct State
+    {
+        float z1 = 0;
+        float z2 = 0;
+    };
+
+    float m_b0 = 0;
+    float m_b1 = 0;
+    float m_b2 = 0;
+    float m_a1 = 0;
+    float m_a2 = 0;
+    std::array<State, MAX_CAPTURE_CHANNELS> m_states{};
+};
+
+// Fixed gain, saturated to the sample range
+class GainStage : public CapturePipeline::Stage
+{
+public:
+    explicit GainStage(Gain gain);
+
+    const char *get_name() const override { return "gain"; }
+    void process(AudioView audio, uint32_t num_channels) override;
+
+private:
+    const Gain m_gain;
+};
+
+// Reorders the processed channels: output channel i takes input channel
+// map[i], e.g. to swap microphones or feed one microphone twice
+class ChannelMapStage : public CapturePipeline::Stage
+{
+public:
+    explicit ChannelMapStage(const std::array<uint8_t, MAX_CAPTURE_CHANNELS> &map);
+
+    const char *get_name() const override { return "channel_map"; }
+    void process(AudioView audio, uint32_t num_channels) override;
+
+private:
+    const std::array<uint8_t, MAX_CAPTURE_CHANNELS> m_map;
+};
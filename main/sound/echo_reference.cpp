@@ -0,0 +1,153 @@
+#include "echo_reference.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+
+// Envelopes are correlated in bins of 8 samples (0.5 ms at 16 kHz)
+constexpr const uint32_t BIN_SAMPLES = 8;
+// Weight of the past correlations, about 1 s of playback at 32 ms reads
+constexpr const float CORRELATION_DECAY = 0.97f;
+// Mean absolute reference level below which the speaker counts as silent
+constexpr const float MIN_REFERENCE_LEVEL = 64.0f;
+// The correlation peak has to stand out from the mean to move the delay
+constexpr const float MIN_PEAK_RATIO = 2.0f;
+// The reference leads the echo by a bin, AEC can't cancel an echo that comes first
+constexpr const uint32_t LEAD_SAMPLES = BIN_SAMPLES;
+
+EchoReference::EchoReference(uint32_t sample_rate)
+    : m_sample_rate(sample_rate), m_max_delay(sample_rate * MAX_DELAY_MS / 1000 / BIN_SAMPLES * BIN_SAMPLES),
+      // the reader looks back at most m_max_delay + MAX_READ_SAMPLES, the
+      // ring is twice that so the writer stays clear of it
+      m_ring(std::bit_ceil(2 * (m_max_delay + MAX_READ_SAMPLES))), m_ring_mask(m_ring.size() - 1),
+      m_history(m_max_delay + MAX_READ_SAMPLES), m_mic_envelope(MAX_READ_SAMPLES / BIN_SAMPLES),
+      m_reference_envelope((m_max_delay + MAX_READ_SAMPLES) / BIN_SAMPLES),
+      m_correlation(m_max_delay / BIN_SAMPLES + 1)
+{
+}
+
+uint32_t EchoReference::get_sample_time(int64_t time_us, uint32_t sample_rate)
+{
+    return static_cast<uint32_t>(time_us * sample_rate / 1000000);
+}
+
+void EchoReference::write(ConstAudioView audio, uint32_t sample_time)
+{
+    assert(audio.get_bits_per_sample() == 16 && audio.get_sample_rate() == m_sample_rate);
+
+    uint32_t position = m_end.load(std::memory_order_relaxed);
+    const int32_t gap = static_cast<int32_t>(sample_time - position);
+    if (gap > 0)
+    {
+        // nothing was played in between, older slots are out of the reader's reach
+        const uint32_t num_zeros = std::min(static_cast<uint32_t>(gap), static_cast<uint32_t>(m_ring.size()));
+        for (uint32_t i = sample_time - num_zeros; i != sample_time; i++)
+            m_ring[i & m_ring_mask] = 0;
+        position = sample_time;
+    }
+
+    const uint32_t num_channels = audio.get_num_channels();
+    const int16_t *data = audio.get_data_typed<int16_t>();
+    for (size_t i = 0; i < audio.get_num_samples(); i++)
+    {
+        int32_t sum = 0;
+        for (uint32_t j = 0; j < num_channels; j++)
+            sum += data[i * num_channels + j];
+        m_ring[(position + i) & m_ring_mask] = static_cast<int16_t>(sum / static_cast<int32_t>(num_channels));
+    }
+    m_end.store(position + audio.get_num_samples(), std::memory_order_release);
+}
+
+void EchoReference::fetch(uint32_t begin, size_t num_samples)
+{
+    const uint32_t end = m_end.load(std::memory_order_acquire);
+    const uint32_t reach = m_ring.size() / 2;
+    for (size_t i = 0; i < num_samples; i++)
+    {
+        const uint32_t index = begin + i;
+        const int32_t age = static_cast<int32_t>(end - index);
+        // not written yet or overwritten: the speaker was silent
+        m_history[i] = age > 0 && static_cast<uint32_t>(age) <= reach ? m_ring[index & m_ring_mask] : 0;
+    }
+}
+
+void EchoReference::read(AudioView audio, uint32_t channel, uint32_t mic_channel, uint32_t end_sample_time)
+{
+    assert(audio.get_bits_per_sample() == 16 && audio.get_sample_rate() == m_sample_rate);
+    assert(audio.get_num_samples() <= MAX_READ_SAMPLES);
+    assert(channel < audio.get_num_channels() && mic_channel < audio.get_num_channels());
+
+    // m_history holds the reference of every delay up to m_max_delay, delay 0 starts at m_max_delay
+    const size_t num_samples = audio.get_num_samples();
+    fetch(end_sample_time - static_cast<uint32_t>(num_samples) - m_max_delay, num_samples + m_max_delay);
+    estimate_delay(audio, mic_channel);
+
+    const uint32_t delay = m_delay > LEAD_SAMPLES ? m_delay - LEAD_SAMPLES : 0;
+    const int16_t *reference = m_history.data() + m_max_delay - delay;
+    const uint32_t num_channels = audio.get_num_channels();
+    int16_t *data = audio.get_data_typed<int16_t>() + channel;
+    for (size_t i = 0; i < num_samples; i++)
+        data[i * num_channels] = reference[i];
+}
+
+static void make_envelope(const int16_t *data, size_t stride, size_t num_bins, float *envelope)
+{
+    float sum = 0;
+    for (size_t k = 0; k < num_bins; k++)
+    {
+        int32_t level = 0;
+        for (size_t i = 0; i < BIN_SAMPLES; i++)
+            level += std::abs(data[(k * BIN_SAMPLES + i) * stride]);
+        envelope[k] = static_cast<float>(level) / BIN_SAMPLES;
+        sum += envelope[k];
+    }
+
+    // without the mean the correlation follows the level instead of the shape
+    const float mean = sum / static_cast<float>(num_bins);
+    for (size_t k = 0; k < num_bins; k++)
+        envelope[k] -= mean;
+}
+
+void EchoReference::estimate_delay(ConstAudioView audio, uint32_t mic_channel)
+{
+    const size_t num_bins = audio.get_num_samples() / BIN_SAMPLES;
+    const size_t num_lags = m_correlation.size();
+    const size_t num_reference_bins = num_bins + num_lags - 1;
+    if (num_bins == 0)
+        return;
+
+    int64_t reference_level = 0;
+    for (size_t i = 0; i < num_reference_bins * BIN_SAMPLES; i++)
+        reference_level += std::abs(m_history[i]);
+    if (static_cast<float>(reference_level) / (num_reference_bins * BIN_SAMPLES) < MIN_REFERENCE_LEVEL)
+        return;
+
+    const uint32_t num_channels = audio.get_num_channels();
+    make_envelope(audio.get_data_typed<int16_t>() + mic_channel, num_channels, num_bins, m_mic_envelope.data());
+    make_envelope(m_history.data(), 1, num_reference_bins, m_reference_envelope.data());
+
+    // mic bin k lines up with reference bin k + num_lags - 1 at delay 0
+    float peak = 0;
+    float sum = 0;
+    size_t peak_lag = 0;
+    for (size_t lag = 0; lag < num_lags; lag++)
+    {
+        const float *reference = m_reference_envelope.data() + num_lags - 1 - lag;
+        float correlation = 0;
+        for (size_t k = 0; k < num_bins; k++)
+            correlation += m_mic_envelope[k] * reference[k];
+
+        m_correlation[lag] = m_correlation[lag] * CORRELATION_DECAY + correlation;
+        sum += std::fabs(m_correlation[lag]);
+        if (m_correlation[lag] > peak)
+        {
+            peak = m_correlation[lag];
+            peak_lag = lag;
+        }
+    }
+
+    if (peak > MIN_PEAK_RATIO * sum / static_cast<float>(num_lags))
+        m_delay = static_cast<uint32_t>(peak_lag * BIN_SAMPLES);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "audio_view.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Loopback of the speaker signal for acoustic echo cancellation. The output
+// path writes what it sends to the speaker, stamped with the sample time it
+// starts playing at. The capture path reads the reference of the samples it
+// just captured, delayed by the echo delay, which is estimated from the
+// correlation of the microphone and reference envelopes while audio plays.
+// Sample times are a wrapping 32-bit sample counter both sides derive from
+// the same clock. One writer and one reader, without locks.
+class EchoReference
+{
+public:
+    // Longest echo delay searched by the estimator, covers output buffering
+    static constexpr const uint32_t MAX_DELAY_MS = 128;
+    // Longest audio read at once
+    static constexpr const size_t MAX_READ_SAMPLES = 1024;
+
+    explicit EchoReference(uint32_t sample_rate);
+
+    static uint32_t get_sample_time(int64_t time_us, uint32_t sample_rate);
+
+    // Output side: audio plays from sample_time on, or right after the
+    // previously written audio if that is still playing. Channels are mixed
+    // down to one reference channel.
+    void write(ConstAudioView audio, uint32_t sample_time);
+
+    // Capture side: fills channel of 16-bit audio with the reference of the
+    // samples captured up to end_sample_time and updates the delay estimate
+    // from mic_channel
+    void read(AudioView audio, uint32_t channel, uint32_t mic_channel, uint32_t end_sample_time);
+
+    uint32_t get_sample_rate() const { return m_sample_rate; }
+    // Estimated echo delay in samples
+    uint32_t get_delay() const { return m_delay; }
+
+private:
+    void fetch(uint32_t begin, size_t num_samples);
+    void estimate_delay(ConstAudioView audio, uint32_t mic_channel);
+
+private:
+    const uint32_t m_sample_rate;
+    const uint32_t m_max_delay;
+
+    // Writer side
+    std::vector<int16_t> m_ring;
+    const uint32_t m_ring_mask;
+    std::atomic<uint32_t> m_end = 0;
+
+    // Reader side
+    std::vector<int16_t> m_history;
+    std::vector<float> m_mic_envelope;
+    std::vector<float> m_reference_envelope;
+    std::vector<float> m_correlation;
+    std::atomic<uint32_t> m_delay = 0;
+};
@@ -0,0 +1,143 @@
+#include "jitter_buffer.h"
+#include "audio_gain.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+static size_t ms_to_samples(uint32_t sample_rate, uint32_t ms)
+{
+    return static_cast<size_t>(sample_rate) * ms / 1000;
+}
+
+JitterBuffer::JitterBuffer(const AudioFormat &format, uint32_t initial_target_ms)
+    : m_format(format), m_min_target(ms_to_samples(format.sample_rate, MIN_TARGET_MS)),
+      m_max_target(ms_to_samples(format.sample_rate, MAX_TARGET_MS)),
+      m_target_step(ms_to_samples(format.sample_rate, TARGET_STEP_MS)),
+      m_stable_samples(ms_to_samples(format.sample_rate, STABLE_MS)),
+      // room for the largest target and half of it again for the producer to run ahead
+      m_ring(format, std::bit_ceil(m_max_target + m_max_target / 2)), m_ring_mask(m_ring.get_num_samples() - 1),
+      m_target(std::clamp(ms_to_samples(format.sample_rate, initial_target_ms), m_min_target, m_max_target)),
+      m_last_sample(format.num_channels, 0)
+{
+    assert(format.bits_per_sample == 16 && !format.floating_point);
+}
+
+size_t JitterBuffer::get_num_buffered_samples() const
+{
+    return m_write_position.load(std::memory_order_acquire) - m_read_position.load(std::memory_order_acquire);
+}
+
+size_t JitterBuffer::get_num_free_samples() const
+{
+    return m_ring.get_num_samples() - get_num_buffered_samples();
+}
+
+size_t JitterBuffer::write(ConstAudioView audio)
+{
+    assert(audio.get_format() == m_format);
+
+    const size_t sample_size = m_format.get_sample_size();
+    const uint32_t position = m_write_position.load(std::memory_order_relaxed);
+    const size_t num_samples = std::min(audio.get_num_samples(), get_num_free_samples());
+    const size_t offset = position & m_ring_mask;
+    const size_t num_first = std::min(num_samples, m_ring.get_num_samples() - offset);
+    memcpy(m_ring.get_data() + offset * sample_size, audio.get_data(), num_first * sample_size);
+    memcpy(m_ring.get_data(), audio.get_data() + num_first * sample_size, (num_samples - num_first) * sample_size);
+    m_write_position.store(position + num_samples, std::memory_order_release);
+    return num_samples;
+}
+
+void JitterBuffer::end_stream()
+{
+    m_end_of_stream = true;
+}
+
+size_t JitterBuffer::copy_out(AudioView audio)
+{
+    const size_t sample_size = m_format.get_sample_size();
+    const uint32_t position = m_read_position.load(std::memory_order_relaxed);
+    const size_t num_samples = std::min(audio.get_num_samples(), get_num_buffered_samples());
+    const size_t offset = position & m_ring_mask;
+    const size_t num_first = std::min(num_samples, m_ring.get_num_samples() - offset);
+    memcpy(audio.get_data(), m_ring.get_data() + offset * sample_size, num_first * sample_size);
+    memcpy(audio.get_data() + num_first * sample_size, m_ring.get_data(), (num_samples - num_first) * sample_size);
+    m_read_position.store(position + num_samples, std::memory_order_release);
+
+    if (num_samples > 0)
+    {
+        const int16_t *last = audio.get_data_typed<int16_t>() + (num_samples - 1) * m_format.num_channels;
+        std::copy(last, last + m_format.num_channels, m_last_sample.begin());
+    }
+    return num_samples;
+}
+
+void JitterBuffer::conceal(AudioView audio)
+{
+    // fades from the last played sample to silence instead of cutting off
+    const uint32_t num_channels = m_format.num_channels;
+    const size_t num_fade = std::min(audio.get_num_samples(), FADE_SAMPLES);
+    int16_t *data = audio.get_data_typed<int16_t>();
+    for (size_t i = 0; i < num_fade; i++)
+    {
+        const int32_t weight = static_cast<int32_t>(FADE_SAMPLES - 1 - i);
+        for (uint32_t j = 0; j < num_channels; j++)
+            data[i * num_channels + j] = static_cast<int16_t>(m_last_sample[j] * weight / FADE_SAMPLES);
+    }
+    const AudioView rest = audio.subview(num_fade, audio.get_num_samples() - num_fade);
+    memset(rest.get_data(), 0, rest.get_size());
+    std::fill(m_last_sample.begin(), m_last_sample.end(), 0);
+}
+
+size_t JitterBuffer::read(AudioView audio)
+{
+    assert(audio.get_format() == m_format);
+
+    if (m_finished)
+        return 0;
+
+    // the end flag has to be read before the level it applies to
+    const bool end_of_stream = m_end_of_stream;
+    if (m_buffering)
+    {
+        if (get_num_buffered_samples() < m_target && !end_of_stream)
+        {
+            memset(audio.get_data(), 0, audio.get_size());
+            return audio.get_num_samples();
+        }
+        m_buffering = false;
+        m_fade_in = true;
+    }
+
+    const size_t num_read = copy_out(audio);
+    if (m_fade_in && num_read > 0)
+    {
+        apply_gain_ramp(audio.subview(0, std::min(num_read, FADE_SAMPLES)), 0, GAIN_UNITY);
+        m_fade_in = false;
+    }
+
+    m_num_stable_samples += num_read;
+    if (m_num_stable_samples >= m_stable_samples)
+    {
+        m_target = std::max(m_target - m_target_step, m_min_target);
+        m_num_stable_samples = 0;
+    }
+
+    if (num_read == audio.get_num_samples())
+        return num_read;
+
+    if (end_of_stream)
+    {
+        m_finished = true;
+        return num_read;
+    }
+
+    // underrun: conceal the gap and rebuffer with more headroom
+    conceal(audio.subview(num_read, audio.get_num_samples() - num_read));
+    m_num_underruns++;
+    m_target = std::min(m_target + m_target_step, m_max_target);
+    m_num_stable_samples = 0;
+    m_buffering = true;
+    return audio.get_num_samples();
+}
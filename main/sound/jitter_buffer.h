@@ -0,0 +1,76 @@
+#pragma once
+
+#include "audio_data.h"
+#include "audio_view.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Buffers 16-bit audio arriving over the network for playback. The consumer
+// waits until the buffer holds the target delay before it starts, so playback
+// begins while the rest is still downloading. On an underrun the last samples
+// fade out and the buffer refills to a target raised by a step; after a stable
+// period the target is lowered again. One producer and one consumer task,
+// without locks.
+class JitterBuffer
+{
+public:
+    static constexpr const uint32_t MIN_TARGET_MS = 80;
+    static constexpr const uint32_t MAX_TARGET_MS = 640;
+    static constexpr const uint32_t TARGET_STEP_MS = 80;
+    // The target is lowered by a step after this long without an underrun
+    static constexpr const uint32_t STABLE_MS = 5000;
+    // Fade out on an underrun and fade in when playback resumes (4 ms at 16 kHz)
+    static constexpr const size_t FADE_SAMPLES = 64;
+
+    explicit JitterBuffer(const AudioFormat &format, uint32_t initial_target_ms = MIN_TARGET_MS);
+
+    // Producer: returns the number of samples written, fewer if the buffer is full
+    size_t write(ConstAudioView audio);
+    size_t get_num_free_samples() const;
+    // No more audio follows, the rest plays without waiting for the target
+    void end_stream();
+    // The consumer is gone, the producer should stop
+    bool is_closed() const { return m_closed; }
+
+    // Consumer: fills audio, returns fewer samples only at the end of the
+    // stream. Outputs silence while buffering.
+    size_t read(AudioView audio);
+    void close() { m_closed = true; }
+    bool is_finished() const { return m_finished; }
+
+    size_t get_num_buffered_samples() const;
+    size_t get_target_samples() const { return m_target; }
+    size_t get_num_underruns() const { return m_num_underruns; }
+    const AudioFormat &get_format() const { return m_format; }
+
+private:
+    size_t copy_out(AudioView audio);
+    void conceal(AudioView audio);
+
+private:
+    const AudioFormat m_format;
+    const size_t m_min_target;
+    const size_t m_max_target;
+    const size_t m_target_step;
+    const size_t m_stable_samples;
+
+    AudioData m_ring;
+    const uint32_t m_ring_mask;
+    std::atomic<uint32_t> m_write_position = 0;
+    std::atomic<uint32_t> m_read_position = 0;
+    std::atomic<bool> m_end_of_stream = false;
+    std::atomic<bool> m_closed = false;
+
+    // Consumer side
+    bool m_buffering = true;
+    bool m_fade_in = false;
+    std::atomic<size_t> m_target = 0;
+    size_t m_num_stable_samples = 0;
+    // last played sample of every channel, the start of the fade out
+    std::vector<int16_t> m_last_sample;
+    std::atomic<bool> m_finished = false;
+    std::atomic<size_t> m_num_underruns = 0;
+};
@@ -0,0 +1,61 @@
+#include "level_meter.h"
+
+#include <algorithm>
+#include <cassert>
+
+LevelMeter::LevelMeter(uint32_t num_channels, uint32_t bucket_ms, size_t capacity)
+    : m_num_channels(num_channels), m_bucket_ms(bucket_ms), m_levels(capacity)
+{
+    assert(num_channels > 0 && bucket_ms > 0);
+}
+
+void LevelMeter::write(ConstAudioView audio)
+{
+    assert(audio.get_bits_per_sample() == 16 && !audio.get_format().floating_point);
+
+    const size_t bucket_samples = std::max<size_t>(1, audio.get_sample_rate() * m_bucket_ms / 1000);
+    const uint32_t stride = audio.get_num_channels();
+    m_bucket_channels = std::min(m_num_channels, stride);
+
+    const int16_t *data = audio.get_data_typed<int16_t>();
+    size_t num_samples = audio.get_num_samples();
+    while (num_samples > 0)
+    {
+        const size_t count = std::min(num_samples, bucket_samples - std::min(m_bucket_position, bucket_samples));
+        int32_t min = m_min;
+        int32_t max = m_max;
+        for (size_t i = 0; i < count; i++, data += stride)
+        {
+            for (uint32_t channel = 0; channel < m_bucket_channels; channel++)
+            {
+                const int32_t value = data[channel];
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+        }
+        m_min = min;
+        m_max = max;
+        m_bucket_position += count;
+        num_samples -= count;
+
+        if (m_bucket_position >= bucket_samples)
+            push_bucket();
+    }
+}
+
+void LevelMeter::push_bucket()
+{
+    m_levels.push({
+        .min = static_cast<int16_t>(m_min),
+        .max = static_cast<int16_t>(m_max),
+    });
+
+    m_bucket_position = 0;
+    m_min = INT16_MAX;
+    m_max = INT16_MIN;
+}
+
+bool LevelMeter::read(Level &level)
+{
+    return m_levels.pop(level);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "audio_view.h"
+#include "spsc_ring.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Level envelope of 16-bit audio for display. The writer folds every bucket
+// of samples into its min and max over the measured channels and pushes it
+// into an SpscRing that the reader drains at its own pace.
+class LevelMeter
+{
+public:
+    struct Level
+    {
+        int16_t min = 0;
+        int16_t max = 0;
+    };
+
+    // Measures the first num_channels of the audio written, capacity is
+    // rounded up to a power of two
+    LevelMeter(uint32_t num_channels, uint32_t bucket_ms, size_t capacity);
+
+    // Writer: a bucket may span several writes
+    void write(ConstAudioView audio);
+
+    // Reader: false if no complete bucket is waiting
+    bool read(Level &level);
+
+    size_t get_num_dropped_levels() const { return m_levels.get_num_dropped(); }
+
+private:
+    void push_bucket();
+
+private:
+    const uint32_t m_num_channels;
+    const uint32_t m_bucket_ms;
+
+    SpscRing<Level> m_levels;
+
+    // Writer side, the bucket being measured
+    size_t m_bucket_position = 0;
+    uint32_t m_bucket_channels = 0;
+    int32_t m_min = INT16_MAX;
+    int32_t m_max = INT16_MIN;
+};
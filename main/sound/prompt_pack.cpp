@@ -0,0 +1,101 @@
+#include "prompt_pack.h"
+
+#include <cstring>
+
+constexpr const uint32_t PROMPT_RESIDENT = 0x1;
+
+struct prompt_pack_header_t
+{
+    char magic[4];
+    uint16_t version;
+    uint16_t num_prompts;
+    uint32_t sample_rate;
+    uint16_t num_channels;
+    uint16_t bits_per_sample;
+    // Bytes from the start of the pack up to the end of the last resident prompt
+    uint32_t resident_size;
+};
+
+struct prompt_pack_entry_t
+{
+    char name[PromptPack::MAX_NAME_SIZE];
+    uint32_t wav_offset;
+    uint32_t data_offset;
+    uint32_t num_samples;
+    uint32_t flags;
+};
+
+bool PromptPack::fail(const char *error)
+{
+    m_error = error;
+    m_resident.clear();
+    m_prompts.clear();
+    return false;
+}
+
+bool PromptPack::load(IReadStream &stream, const AudioFormat &format)
+{
+    m_error = nullptr;
+
+    prompt_pack_header_t header;
+    if (stream.read(&header, sizeof(header)) != sizeof(header))
+        return fail("truncated header");
+    if (memcmp(header.magic, "NPRM", sizeof(header.magic)) != 0)
+        return fail("not a prompt pack");
+    if (header.version != VERSION)
+        return fail("unsupported version");
+
+    const AudioFormat pack_format = {
+        .num_channels = header.num_channels,
+        .bits_per_sample = header.bits_per_sample,
+        .sample_rate = header.sample_rate,
+    };
+    if (pack_format != format)
+        return fail("built for another output format");
+
+    const size_t index_size = sizeof(header) + header.num_prompts * sizeof(prompt_pack_entry_t);
+    if (header.resident_size < index_size)
+        return fail("invalid resident size");
+
+    m_resident.resize(header.resident_size);
+    memcpy(m_resident.data(), &header, sizeof(header));
+    const size_t rest = header.resident_size - sizeof(header);
+    if (stream.read(m_resident.data() + sizeof(header), rest) != rest)
+        return fail("truncated pack");
+
+    const auto *entries = reinterpret_cast<const prompt_pack_entry_t *>(m_resident.data() + sizeof(header));
+    m_prompts.clear();
+    m_prompts.reserve(header.num_prompts);
+    for (size_t i = 0; i < header.num_prompts; i++)
+    {
+        const prompt_pack_entry_t &entry = entries[i];
+        if (entry.name[MAX_NAME_SIZE - 1] != '\0')
+            return fail("invalid prompt name");
+
+        Prompt prompt = {
+            .name = entry.name,
+            .wav_offset = entry.wav_offset,
+            .num_samples = entry.num_samples,
+            .audio = {},
+        };
+        if (entry.flags & PROMPT_RESIDENT)
+        {
+            const size_t size = static_cast<size_t>(entry.num_samples) * format.get_sample_size();
+            if (entry.data_offset > header.resident_size || size > header.resident_size - entry.data_offset)
+                return fail("resident prompt out of range");
+            prompt.audio = ConstAudioView(format, m_resident.data() + entry.data_offset, entry.num_samples);
+        }
+        m_prompts.push_back(prompt);
+    }
+    return true;
+}
+
+const PromptPack::Prompt *PromptPack::find(const char *name) const
+{
+    for (const Prompt &prompt : m_prompts)
+    {
+        if (strcmp(prompt.name, name) == 0)
+            return &prompt;
+    }
+    return nullptr;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "audio_view.h"
+#include "read_stream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Prompts packed into one file by tools/build_prompts.py. They are converted
+// to the device output format with their gain applied at build time, so loading
+// does no per-sample work. Every prompt is stored as a canonical WAV and can be
+// streamed from its offset. Short prompts are packed right after the index and
+// load() reads both in one go, then they are looked up in place.
+class PromptPack
+{
+public:
+    static constexpr const uint16_t VERSION = 1;
+    // Including the terminating zero
+    static constexpr const size_t MAX_NAME_SIZE = 16;
+
+    struct Prompt
+    {
+        const char *name = nullptr;
+        // Offset of the prompt's WAV in the pack
+        uint32_t wav_offset = 0;
+        size_t num_samples = 0;
+        // Samples of a resident prompt, empty if it has to be streamed
+        ConstAudioView audio;
+    };
+
+    // Reads the index and the resident prompts. Fails if the pack was built
+    // for another output format.
+    bool load(IReadStream &stream, const AudioFormat &format);
+    const char *get_error() const { return m_error; }
+
+    // Null if the pack has no such prompt
+    const Prompt *find(const char *name) const;
+    const std::vector<Prompt> &get_prompts() const { return m_prompts; }
+
+private:
+    bool fail(const char *error);
+
+private:
+    const char *m_error = nullptr;
+    // Header, index and resident prompts as stored
+    std::vector<int8_t> m_resident;
+    std::vector<Prompt> m_prompts;
+};
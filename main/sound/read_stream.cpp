@@ -0,0 +1,36 @@
+#include "read_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+FileReadStream::~FileReadStream()
+{
+    if (m_owned && m_file != nullptr)
+        fclose(m_file);
+}
+
+size_t FileReadStream::read(void *buffer, size_t size)
+{
+    return fread(buffer, 1, size, m_file);
+}
+
+bool FileReadStream::skip(size_t size)
+{
+    return fseek(m_file, static_cast<long>(size), SEEK_CUR) == 0;
+}
+
+size_t MemoryReadStream::read(void *buffer, size_t size)
+{
+    const size_t num_read = std::min(size, m_size - m_position);
+    memcpy(buffer, m_data + m_position, num_read);
+    m_position += num_read;
+    return num_read;
+}
+
+bool MemoryReadStream::skip(size_t size)
+{
+    if (size > m_size - m_position)
+        return false;
+    m_position += size;
+    return true;
+}
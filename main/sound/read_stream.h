@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Sequential byte source used by the streaming decoders
+struct IReadStream
+{
+    virtual ~IReadStream() = default;
+
+    // Returns the number of bytes read, less than size at the end of the stream
+    virtual size_t read(void *buffer, size_t size) = 0;
+    virtual bool skip(size_t size) = 0;
+};
+
+// Reads from an open file, an owned file is closed with the stream
+class FileReadStream : public IReadStream
+{
+public:
+    explicit FileReadStream(FILE *file, bool owned = false) : m_file(file), m_owned(owned) {}
+    ~FileReadStream() override;
+
+    FileReadStream(const FileReadStream &) = delete;
+    FileReadStream &operator=(const FileReadStream &) = delete;
+
+    size_t read(void *buffer, size_t size) override;
+    bool skip(size_t size) override;
+
+private:
+    FILE *m_file = nullptr;
+    bool m_owned = false;
+};
+
+// Reads from a memory region, e.g. a buffer or a memory mapped flash partition
+class MemoryReadStream : public IReadStream
+{
+public:
+    MemoryReadStream(const void *data, size_t size) : m_data(static_cast<const int8_t *>(data)), m_size(size) {}
+
+    size_t read(void *buffer, size_t size) override;
+    bool skip(size_t size) override;
+
+    const int8_t *get_position() const { return m_data + m_position; }
+
+private:
+    const int8_t *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_position = 0;
+};
@@ -1,6 +1,7 @@
 #include "speech_recognition.h"
 
 #include "nossat_err.h"
+#include "system/latency_probes.h"
 
 #include "esp_afe_sr_models.h"
 #include "esp_mn_models.h"
@@ -88,10 +89,11 @@ size_t SpeechRecognition::get_feed_chunksize() const
     return m_afe_handle->get_feed_chunksize(m_afe_data);
 }
 
-void SpeechRecognition::feed(const AudioData &audio)
+void SpeechRecognition::feed(ConstAudioView audio)
 {
     assert(audio.get_format() == AUDIO_FORMAT);
-    m_afe_handle->feed(m_afe_data, audio.get_data_typed<int16_t>());
+    const FeedAudioView feed_audio(audio);
+    m_afe_handle->feed(m_afe_data, feed_audio.get_data());
 }
 
 void SpeechRecognition::audio_detect_task()
@@ -117,7 +119,13 @@ void SpeechRecognition::audio_detect_task()
 
         case WAKENET_DETECTED:
             ESP_LOGI(TAG, "Wake word detected");
-            m_event_loop->post(std::bind(&IObserver::on_waiting_for_command, m_observer));
+            LatencyProbes::instance().begin(LatencyProbes::Path::WAKE);
+            m_event_loop->post(
+                [this]
+                {
+                    LatencyProbes::instance().mark(LatencyProbes::Path::WAKE, LatencyProbes::Stage::DISPATCHED);
+                    m_observer->on_waiting_for_command();
+                });
             break;
 
         case WAKENET_CHANNEL_VERIFIED:
@@ -137,12 +145,20 @@ void SpeechRecognition::audio_detect_task()
             break;
         case ESP_MN_STATE_TIMEOUT: {
             ESP_LOGW(TAG, "Timeout");
-            m_event_loop->post(std::bind(&IObserver::on_command_not_detected, m_observer));
+            LatencyProbes::instance().begin(LatencyProbes::Path::NOT_RECOGNIZED);
+            m_event_loop->post(
+                [this]
+                {
+                    LatencyProbes::instance().mark(LatencyProbes::Path::NOT_RECOGNIZED,
+                                                   LatencyProbes::Stage::DISPATCHED);
+                    m_observer->on_command_not_detected();
+                });
             m_afe_handle->enable_wakenet(m_afe_data);
             detect_flag = false;
             break;
         }
         case ESP_MN_STATE_DETECTED: {
+            LatencyProbes::instance().begin(LatencyProbes::Path::COMMAND);
             esp_mn_results_t *mn_result = m_multinet->get_results(m_model_data);
             for (int i = 0; i < mn_result->num; i++)
             {
@@ -154,6 +170,7 @@ void SpeechRecognition::audio_detect_task()
             ESP_LOGI(TAG, "Deteted command : %d", command_id);
             const auto on_command_detected = [this, command_id]
             {
+                LatencyProbes::instance().mark(LatencyProbes::Path::COMMAND, LatencyProbes::Stage::DISPATCHED);
                 ESP_TRUE_CHECK(command_id < m_commands.size());
                 const auto &command = m_commands[command_id];
 
@@ -5,6 +5,7 @@
 
 #include "system/event_loop.h"
 #include "hal/audio_input.h"
+#include "sound/audio_buffer.h"
 
 #include <functional>
 #include <memory>
@@ -12,6 +13,9 @@
 class SpeechRecognition
 {
 public:
+    // AUDIO_FORMAT as a typed view: two microphone channels and one reference channel
+    using FeedAudioView = TypedAudioView<const int16_t, 3>;
+
     static const AudioFormat AUDIO_FORMAT;
     static const uint32_t INPUT_CHANNEL_COUNT;
     static const uint32_t REFERENCE_CHANNEL_COUNT;
@@ -37,7 +41,7 @@ public:
 
 public:
     size_t get_feed_chunksize() const;
-    void feed(const AudioData &audio);
+    void feed(ConstAudioView audio);
     void audio_detect_task();
 
 private:
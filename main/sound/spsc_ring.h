@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed ring of items from one producer to one consumer, without locks. The
+// producer never waits, an item that finds the ring full is dropped and
+// counted, so it may run in an ISR. Neither side allocates.
+template <typename T> class SpscRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) : m_items(std::bit_ceil(capacity)), m_mask(m_items.size() - 1)
+    {
+        assert(capacity > 0);
+    }
+
+    // Producer: the slot to fill in place, null (and a drop counted) if the
+    // ring is full. The item is published by end_push().
+    T *begin_push()
+    {
+        const uint32_t position = m_write_position.load(std::memory_order_relaxed);
+        if (position - m_read_position.load(std::memory_order_acquire) == m_items.size())
+        {
+            m_num_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &m_items[position & m_mask];
+    }
+
+    // only the producer moves the write position, no read-modify-write needed
+    void end_push()
+    {
+        m_write_position.store(m_write_position.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool push(const T &item)
+    {
+        T *slot = begin_push();
+        if (slot == nullptr)
+            return false;
+        *slot = item;
+        end_push();
+        return true;
+    }
+
+    // Consumer: the oldest item, null if the ring is empty. It stays valid
+    // until pop().
+    const T *front() const
+    {
+        const uint32_t position = m_read_position.load(std::memory_order_relaxed);
+        if (position == m_write_position.load(std::memory_order_acquire))
+            return nullptr;
+        return &m_items[position & m_mask];
+    }
+
+    void pop()
+    {
+        const uint32_t position = m_read_position.load(std::memory_order_relaxed);
+        assert(position != m_write_position.load(std::memory_order_relaxed));
+        m_read_position.store(position + 1, std::memory_order_release);
+    }
+
+    bool pop(T &item)
+    {
+        const T *oldest = front();
+        if (oldest == nullptr)
+            return false;
+        item = *oldest;
+        pop();
+        return true;
+    }
+
+    size_t size() const
+    {
+        return m_write_position.load(std::memory_order_acquire) - m_read_position.load(std::memory_order_acquire);
+    }
+    size_t get_capacity() const { return m_items.size(); }
+    size_t get_num_dropped() const { return m_num_dropped.load(std::memory_order_relaxed); }
+
+    // Setup before any push, e.g. to point every slot at its own storage
+    T &get_slot(size_t index) { return m_items[index]; }
+    size_t get_slot_index(const T *item) const { return item - m_items.data(); }
+
+private:
+    std::vector<T> m_items;
+    const uint32_t m_mask;
+    std::atomic<uint32_t> m_write_position = 0;
+    std::atomic<uint32_t> m_read_position = 0;
+    std::atomic<size_t> m_num_dropped = 0;
+};
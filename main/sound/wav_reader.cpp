@@ -0,0 +1,273 @@
+#include "wav_reader.h"
+#include "adpcm.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+constexpr const uint16_t WAVE_FORMAT_PCM = 0x0001;
+constexpr const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+constexpr const uint16_t WAVE_FORMAT_IMA_ADPCM = 0x0011;
+constexpr const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+constexpr const uint32_t MIN_FORMAT_CHUNK_SIZE = 16;
+constexpr const uint32_t EXTENSIBLE_FORMAT_CHUNK_SIZE = 40;
+constexpr const uint32_t MAX_NUM_CHANNELS = 8;
+
+struct chunk_header_t
+{
+    char id[4];
+    uint32_t size;
+};
+
+struct riff_header_t
+{
+    char id[4];
+    uint32_t size;
+    char format[4];
+};
+
+struct format_chunk_t
+{
+    uint16_t audio_format;
+    uint16_t num_channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+};
+
+struct format_extension_t
+{
+    uint16_t extension_size;
+    uint16_t valid_bits_per_sample;
+    uint32_t channel_mask;
+    uint16_t sub_format;
+    uint8_t guid_tail[14];
+};
+
+static bool is_id(const char (&id)[4], const char *expected)
+{
+    return memcmp(id, expected, sizeof(id)) == 0;
+}
+
+bool WavReader::fail(const char *error)
+{
+    m_error = error;
+    m_stream = nullptr;
+    m_format = {};
+    m_num_samples = 0;
+    m_num_read_samples = 0;
+    m_block_size = 0;
+    return false;
+}
+
+bool WavReader::open(IReadStream &stream)
+{
+    m_stream = &stream;
+    m_error = nullptr;
+    m_format = {};
+    m_num_samples = 0;
+    m_num_read_samples = 0;
+    m_block_size = 0;
+    m_num_decoded_samples = 0;
+    m_decoded_pos = 0;
+
+    // number of samples from the fact chunk of compressed streams
+    size_t fact_num_samples = SIZE_MAX;
+
+    riff_header_t riff;
+    if (stream.read(&riff, sizeof(riff)) != sizeof(riff))
+        return fail("truncated RIFF header");
+    if (!is_id(riff.id, "RIFF") || !is_id(riff.format, "WAVE"))
+        return fail("not a RIFF/WAVE stream");
+
+    while (true)
+    {
+        chunk_header_t chunk;
+        if (stream.read(&chunk, sizeof(chunk)) != sizeof(chunk))
+            return fail("no data chunk");
+
+        if (is_id(chunk.id, "fmt "))
+        {
+            if (!read_format_chunk(chunk.size))
+                return false;
+        }
+        else if (is_id(chunk.id, "fact") && chunk.size >= sizeof(uint32_t))
+        {
+            uint32_t num_samples;
+            if (stream.read(&num_samples, sizeof(num_samples)) != sizeof(num_samples))
+                return fail("truncated fact chunk");
+            const uint32_t rest = chunk.size - sizeof(num_samples);
+            if (!stream.skip(rest + (chunk.size & 1)))
+                return fail("truncated fact chunk");
+            fact_num_samples = num_samples;
+        }
+        else if (is_id(chunk.id, "data"))
+        {
+            if (m_format == AudioFormat())
+                return fail("data chunk before fmt chunk");
+
+            if (is_adpcm())
+            {
+                const size_t num_full_blocks = chunk.size / m_block_size;
+                const size_t last_block_size = chunk.size % m_block_size;
+                m_num_samples = num_full_blocks * get_adpcm_samples_per_block(m_format.num_channels, m_block_size) +
+                                get_adpcm_samples_per_block(m_format.num_channels, last_block_size);
+                m_num_samples = std::min(m_num_samples, fact_num_samples);
+                m_num_remaining_bytes = chunk.size;
+            }
+            else
+            {
+                m_num_samples = chunk.size / m_format.get_sample_size();
+            }
+            return true;
+        }
+        else
+        {
+            // chunks are padded to an even size
+            if (!stream.skip(chunk.size + (chunk.size & 1)))
+                return fail("truncated chunk");
+        }
+    }
+}
+
+bool WavReader::read_format_chunk(uint32_t size)
+{
+    if (size < MIN_FORMAT_CHUNK_SIZE)
+        return fail("fmt chunk is too small");
+
+    format_chunk_t format;
+    if (m_stream->read(&format, sizeof(format)) != sizeof(format))
+        return fail("truncated fmt chunk");
+    size -= sizeof(format);
+
+    uint16_t audio_format = format.audio_format;
+    if (audio_format == WAVE_FORMAT_EXTENSIBLE && size + sizeof(format) >= EXTENSIBLE_FORMAT_CHUNK_SIZE)
+    {
+        format_extension_t extension;
+        if (m_stream->read(&extension, sizeof(extension)) != sizeof(extension))
+            return fail("truncated fmt chunk");
+        size -= sizeof(extension);
+        audio_format = extension.sub_format;
+    }
+
+    if (!m_stream->skip(size + (size & 1)))
+        return fail("truncated fmt chunk");
+
+    if (audio_format == WAVE_FORMAT_IMA_ADPCM)
+        return read_adpcm_format(format);
+
+    const bool floating_point = audio_format == WAVE_FORMAT_IEEE_FLOAT;
+    if (audio_format != WAVE_FORMAT_PCM && !floating_point)
+        return fail("not a PCM stream");
+    if (format.num_channels == 0 || format.num_channels > MAX_NUM_CHANNELS)
+        return fail("unsupported number of channels");
+    if (floating_point ? format.bits_per_sample != 32
+                       : format.bits_per_sample != 8 && format.bits_per_sample != 16 &&
+                             format.bits_per_sample != 24 && format.bits_per_sample != 32)
+        return fail("unsupported bits per sample");
+    if (format.sample_rate == 0)
+        return fail("invalid sample rate");
+    if (format.block_align != format.num_channels * format.bits_per_sample / 8)
+        return fail("invalid block align");
+
+    m_format = AudioFormat{
+        .num_channels = format.num_channels,
+        .bits_per_sample = format.bits_per_sample,
+        .sample_rate = format.sample_rate,
+        .floating_point = floating_point,
+    };
+    return true;
+}
+
+bool WavReader::read_adpcm_format(const format_chunk_t &format)
+{
+    if (format.num_channels == 0 || format.num_channels > ADPCM_MAX_NUM_CHANNELS)
+        return fail("unsupported number of channels");
+    if (format.bits_per_sample != ADPCM_BITS_PER_SAMPLE)
+        return fail("unsupported bits per sample");
+    if (format.sample_rate == 0)
+        return fail("invalid sample rate");
+    if (get_adpcm_samples_per_block(format.num_channels, format.block_align) == 0)
+        return fail("invalid block align");
+
+    m_format = AudioFormat{
+        .num_channels = format.num_channels,
+        .bits_per_sample = 16,
+        .sample_rate = format.sample_rate,
+    };
+    m_block_size = format.block_align;
+    m_block.resize(m_block_size);
+    m_decoded.resize(get_adpcm_samples_per_block(format.num_channels, m_block_size) * format.num_channels);
+    return true;
+}
+
+size_t WavReader::read(AudioView audio)
+{
+    assert(m_stream != nullptr);
+    assert(audio.get_format() == m_format);
+
+    if (is_adpcm())
+        return read_adpcm(audio);
+
+    const size_t sample_size = m_format.get_sample_size();
+    const size_t num_requested = std::min(audio.get_num_samples(), get_num_remaining_samples());
+    const size_t num_read = m_stream->read(audio.get_data(), num_requested * sample_size) / sample_size;
+    m_num_read_samples += num_read;
+    if (num_read < num_requested)
+    {
+        // the stream is shorter than the data chunk claims
+        m_num_samples = m_num_read_samples;
+    }
+
+    if (needs_conversion())
+    {
+        // 8-bit WAV samples are unsigned
+        int8_t *data = audio.get_data();
+        const size_t size = num_read * sample_size;
+        for (size_t i = 0; i < size; i++)
+            data[i] = static_cast<int8_t>(static_cast<uint8_t>(data[i]) ^ 0x80);
+    }
+
+    return num_read;
+}
+
+size_t WavReader::read_adpcm(AudioView audio)
+{
+    const size_t sample_size = m_format.get_sample_size();
+    const size_t num_requested = std::min(audio.get_num_samples(), get_num_remaining_samples());
+
+    size_t num_read = 0;
+    while (num_read < num_requested)
+    {
+        if (m_decoded_pos == m_num_decoded_samples && !decode_next_block())
+        {
+            // the stream is shorter than the data chunk claims
+            m_num_samples = m_num_read_samples + num_read;
+            break;
+        }
+
+        const size_t num_copied = std::min(num_requested - num_read, m_num_decoded_samples - m_decoded_pos);
+        memcpy(audio.get_data() + num_read * sample_size, &m_decoded[m_decoded_pos * m_format.num_channels],
+               num_copied * sample_size);
+        m_decoded_pos += num_copied;
+        num_read += num_copied;
+    }
+
+    m_num_read_samples += num_read;
+    return num_read;
+}
+
+bool WavReader::decode_next_block()
+{
+    const size_t size = std::min(m_block_size, m_num_remaining_bytes);
+    const size_t num_read = m_stream->read(m_block.data(), size);
+    m_num_remaining_bytes -= num_read;
+
+    const AudioView decoded(m_format, reinterpret_cast<int8_t *>(m_decoded.data()),
+                            m_decoded.size() / m_format.num_channels);
+    m_num_decoded_samples = decode_adpcm_block(m_block.data(), num_read, decoded);
+    m_decoded_pos = 0;
+    return m_num_decoded_samples > 0;
+}
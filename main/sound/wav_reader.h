@@ -0,0 +1,55 @@
+#pragma once
+
+#include "audio_view.h"
+#include "read_stream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct format_chunk_t;
+
+// Streaming RIFF/WAVE decoder. open() walks the chunk list up to the "data"
+// chunk, skipping LIST, fact and other unknown chunks, and validates the
+// "fmt " chunk. Samples are then decoded incrementally into caller buffers.
+// IMA ADPCM streams are decoded block by block and read as 16-bit PCM.
+class WavReader
+{
+public:
+    WavReader() = default;
+
+    bool open(IReadStream &stream);
+
+    // Reads up to audio.get_num_samples() samples, returns the number of samples read
+    size_t read(AudioView audio);
+
+    const AudioFormat &get_format() const { return m_format; }
+    size_t get_num_samples() const { return m_num_samples; }
+    size_t get_num_remaining_samples() const { return m_num_samples - m_num_read_samples; }
+    // Unsigned 8-bit samples are converted to signed and ADPCM is decoded on read
+    bool needs_conversion() const { return m_format.bits_per_sample == 8 || is_adpcm(); }
+    bool is_adpcm() const { return m_block_size != 0; }
+    const char *get_error() const { return m_error; }
+
+private:
+    bool fail(const char *error);
+    bool read_format_chunk(uint32_t size);
+    bool read_adpcm_format(const format_chunk_t &format);
+    size_t read_adpcm(AudioView audio);
+    bool decode_next_block();
+
+private:
+    IReadStream *m_stream = nullptr;
+    AudioFormat m_format;
+    size_t m_num_samples = 0;
+    size_t m_num_read_samples = 0;
+    const char *m_error = nullptr;
+
+    // ADPCM block size, 0 for PCM
+    size_t m_block_size = 0;
+    size_t m_num_remaining_bytes = 0;
+    std::vector<uint8_t> m_block;
+    std::vector<int16_t> m_decoded;
+    size_t m_num_decoded_samples = 0;
+    size_t m_decoded_pos = 0;
+};
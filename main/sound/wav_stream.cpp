@@ -0,0 +1,109 @@
+#include "wav_stream.h"
+#include "audio_convert.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+WavStream::WavStream(std::unique_ptr<IReadStream> stream, const AudioFormat &output_format, size_t buffer_samples)
+    : m_stream(std::move(stream)), m_output_format(output_format),
+      m_buffers{AudioData(output_format, buffer_samples), AudioData(output_format, buffer_samples)}
+{
+    assert(m_stream);
+}
+
+bool WavStream::fail(const char *error)
+{
+    m_error = error;
+    return false;
+}
+
+bool WavStream::open()
+{
+    if (!m_reader.open(*m_stream))
+        return fail(m_reader.get_error());
+
+    const AudioFormat &format = m_reader.get_format();
+    if (format.sample_rate != m_output_format.sample_rate)
+        return fail("Sample rate differs from the output");
+    if (format.num_channels != m_output_format.num_channels && format.num_channels != 1)
+        return fail("Channels can't be mapped to the output");
+
+    if (format != m_output_format)
+        m_decoded = AudioData(format, m_buffers[0].get_num_samples());
+
+    fill();
+    return true;
+}
+
+size_t WavStream::decode(AudioView buffer)
+{
+    if (m_decoded.is_empty())
+        return m_reader.read(buffer);
+
+    const size_t num_samples = m_reader.read(m_decoded);
+    convert_samples_upmix(m_decoded.view().subview(0, num_samples), buffer.subview(0, num_samples));
+    return num_samples;
+}
+
+bool WavStream::needs_fill() const
+{
+    return !m_end_of_stream && m_num_buffer_samples[m_write_index] == 0;
+}
+
+void WavStream::fill()
+{
+    while (needs_fill())
+    {
+        AudioData &buffer = m_buffers[m_write_index];
+        const size_t num_samples = decode(buffer);
+        // the samples have to be visible before the end flag
+        m_num_buffer_samples[m_write_index] = num_samples;
+        if (num_samples < buffer.get_num_samples())
+            m_end_of_stream = true;
+        m_write_index ^= 1;
+    }
+}
+
+size_t WavStream::read(AudioView audio)
+{
+    assert(audio.get_format() == m_output_format);
+
+    const size_t sample_size = m_output_format.get_sample_size();
+    size_t num_read = 0;
+    while (num_read < audio.get_num_samples() && !m_finished)
+    {
+        const bool end_of_stream = m_end_of_stream;
+        const size_t num_buffer_samples = m_num_buffer_samples[m_read_index];
+        if (num_buffer_samples == 0)
+        {
+            if (end_of_stream)
+            {
+                m_finished = true;
+                break;
+            }
+
+            // underrun: keep the voice alive with silence
+            const AudioView rest = audio.subview(num_read, audio.get_num_samples() - num_read);
+            memset(rest.get_data(), 0, rest.get_size());
+            m_num_underruns++;
+            return audio.get_num_samples();
+        }
+
+        const size_t num_samples = std::min(audio.get_num_samples() - num_read, num_buffer_samples - m_read_position);
+        memcpy(audio.subview(num_read, num_samples).get_data(),
+               m_buffers[m_read_index].get_data() + m_read_position * sample_size, num_samples * sample_size);
+        num_read += num_samples;
+        m_read_position += num_samples;
+
+        if (m_read_position == num_buffer_samples)
+        {
+            m_num_buffer_samples[m_read_index] = 0;
+            m_read_index ^= 1;
+            m_read_position = 0;
+            if (m_on_drained)
+                m_on_drained();
+        }
+    }
+    return num_read;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "audio_data.h"
+#include "audio_view.h"
+#include "read_stream.h"
+#include "wav_reader.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// Double-buffered WAV decoding for streaming playback. The consumer reads one
+// buffer while the producer decodes the next chunk of the stream into the
+// other one, so long audio plays with a small, constant amount of RAM.
+// Samples are converted to the output format while decoding, the sample rate
+// has to match and mono is duplicated to every output channel. read() and
+// fill() may run on different tasks, one each, without locks.
+class WavStream
+{
+public:
+    // 64 ms at 16 kHz
+    static constexpr const size_t DEFAULT_BUFFER_SAMPLES = 1024;
+
+    WavStream(std::unique_ptr<IReadStream> stream, const AudioFormat &output_format,
+              size_t buffer_samples = DEFAULT_BUFFER_SAMPLES);
+
+    // Parses the header and decodes the first buffer. False if the stream is
+    // not a WAV that can be converted to the output format.
+    bool open();
+    const char *get_error() const { return m_error; }
+
+    // Consumer: fills audio, returns fewer samples only at the end of the
+    // stream. Missing samples of a late producer are output as silence.
+    size_t read(AudioView audio);
+    bool is_finished() const { return m_finished; }
+    size_t get_num_underruns() const { return m_num_underruns; }
+
+    // Producer: decodes into the buffer drained by read(), if any
+    void fill();
+    bool needs_fill() const;
+    // Called by read() when a buffer is drained, e.g. to wake the producer
+    void set_on_drained(std::function<void()> on_drained) { m_on_drained = std::move(on_drained); }
+
+    const AudioFormat &get_format() const { return m_output_format; }
+
+private:
+    bool fail(const char *error);
+    size_t decode(AudioView buffer);
+
+private:
+    const std::unique_ptr<IReadStream> m_stream;
+    const AudioFormat m_output_format;
+    WavReader m_reader;
+    const char *m_error = nullptr;
+    std::function<void()> m_on_drained;
+
+    AudioData m_buffers[2];
+    // Samples in each buffer, 0 while it belongs to the producer
+    std::atomic<size_t> m_num_buffer_samples[2] = {0, 0};
+    std::atomic<bool> m_end_of_stream = false;
+    // Stream samples before conversion to the output format
+    AudioData m_decoded;
+
+    // Producer side
+    size_t m_write_index = 0;
+
+    // Consumer side
+    size_t m_read_index = 0;
+    size_t m_read_position = 0;
+    std::atomic<bool> m_finished = false;
+    size_t m_num_underruns = 0;
+};
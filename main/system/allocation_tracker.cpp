@@ -0,0 +1,81 @@
+#include "allocation_tracker.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#include <atomic>
+#include <cassert>
+
+static const char *TAG = "allocation_tracker";
+
+static std::atomic<TaskHandle_t> g_tracked_task = nullptr;
+static std::atomic<size_t> g_num_allocations = 0;
+static std::atomic<size_t> g_num_frees = 0;
+
+#if CONFIG_NOSSAT_CHECK_FEED_ALLOCATIONS
+
+static std::atomic<size_t> g_num_allocated_bytes = 0;
+
+// Called by the heap for every allocation and free of any task, also from
+// ISRs, so they live in IRAM and must not allocate themselves
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (xTaskGetCurrentTaskHandle() != g_tracked_task.load(std::memory_order_relaxed))
+        return;
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+    if (xTaskGetCurrentTaskHandle() != g_tracked_task.load(std::memory_order_relaxed))
+        return;
+    g_num_frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif
+
+AllocationTracker::AllocationTracker(size_t num_warmup_iterations) : m_num_warmup_iterations(num_warmup_iterations)
+{
+    TaskHandle_t no_task = nullptr;
+    if (!g_tracked_task.compare_exchange_strong(no_task, xTaskGetCurrentTaskHandle()))
+        assert(!"another task is tracked");
+}
+
+AllocationTracker::~AllocationTracker()
+{
+    g_tracked_task = nullptr;
+}
+
+size_t AllocationTracker::get_num_allocations() const
+{
+    return g_num_allocations;
+}
+
+size_t AllocationTracker::get_num_frees() const
+{
+    return g_num_frees;
+}
+
+void AllocationTracker::end_iteration()
+{
+#if CONFIG_NOSSAT_CHECK_FEED_ALLOCATIONS
+    const size_t num_allocations = g_num_allocations;
+    const size_t num_frees = g_num_frees;
+    if (++m_num_iterations > m_num_warmup_iterations &&
+        (num_allocations != m_num_checked_allocations || num_frees != m_num_checked_frees))
+    {
+        ESP_LOGE(TAG, "Iteration %d touched the heap: %d allocations, %d frees (%d bytes allocated in total)",
+                 static_cast<int>(m_num_iterations), static_cast<int>(num_allocations - m_num_checked_allocations),
+                 static_cast<int>(num_frees - m_num_checked_frees), static_cast<int>(g_num_allocated_bytes.load()));
+        assert(!"heap activity in steady state");
+    }
+    if (m_num_iterations == m_num_warmup_iterations)
+        ESP_LOGI(TAG, "Warmed up after %d allocations, checking from now on", static_cast<int>(num_allocations));
+    m_num_checked_allocations = num_allocations;
+    m_num_checked_frees = num_frees;
+#endif
+}
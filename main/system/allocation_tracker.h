@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts the heap allocations and frees of the task that created it, to
+// check that a real-time loop leaves the heap alone once it is warmed up.
+// The heap only reports to it with CONFIG_NOSSAT_CHECK_FEED_ALLOCATIONS,
+// otherwise it counts nothing and checks nothing. One tracker at a time.
+class AllocationTracker
+{
+public:
+    // The first num_warmup_iterations of the loop may allocate
+    explicit AllocationTracker(size_t num_warmup_iterations);
+    ~AllocationTracker();
+
+    // Called at the end of every iteration of the loop, aborts if a warmed up
+    // iteration allocated or freed
+    void end_iteration();
+
+    size_t get_num_allocations() const;
+    size_t get_num_frees() const;
+
+private:
+    const size_t m_num_warmup_iterations;
+    size_t m_num_iterations = 0;
+    size_t m_num_checked_allocations = 0;
+    size_t m_num_checked_frees = 0;
+};
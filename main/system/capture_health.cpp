@@ -0,0 +1,96 @@
+#include "capture_health.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Jitter is a fraction of a millisecond
+constexpr const int REPORT_DECIMALS = 2;
+
+constexpr const auto SNAPSHOT_POLL_PERIOD = std::chrono::milliseconds(5);
+
+CaptureHealth &CaptureHealth::instance()
+{
+    static CaptureHealth health;
+    return health;
+}
+
+void CaptureHealth::record_read(int64_t duration_us, int64_t capture_time_us)
+{
+    m_histograms.read.record(duration_us);
+    if (m_last_capture_time_us != 0)
+    {
+        const int64_t period_us = capture_time_us - m_last_capture_time_us;
+        m_histograms.period.record(period_us);
+        // jitter is the change of the period from one chunk to the next
+        if (m_last_period_us != 0)
+            m_histograms.jitter.record(std::llabs(period_us - m_last_period_us));
+        m_last_period_us = period_us;
+    }
+    m_last_capture_time_us = capture_time_us;
+}
+
+void CaptureHealth::record_feed(int64_t duration_us)
+{
+    m_histograms.feed.record(duration_us);
+}
+
+void CaptureHealth::end_iteration(size_t num_overflows, size_t num_dropped_samples)
+{
+    m_num_overflows.store(num_overflows, std::memory_order_relaxed);
+    m_num_dropped_samples.store(num_dropped_samples, std::memory_order_relaxed);
+
+    const uint32_t requested = m_requested_sequence.load(std::memory_order_acquire);
+    if (requested == m_served_sequence.load(std::memory_order_relaxed))
+        return;
+
+    // a few KB copied once per report, the feed task never allocates here
+    m_snapshot = m_histograms;
+    if (m_restart_requested.exchange(false, std::memory_order_relaxed))
+        m_histograms = Histograms();
+    m_served_sequence.store(requested, std::memory_order_release);
+}
+
+std::string CaptureHealth::make_report(bool restart)
+{
+    std::lock_guard<std::mutex> lock(m_report_mutex);
+    m_restart_requested.store(restart, std::memory_order_relaxed);
+    const uint32_t sequence = m_requested_sequence.load(std::memory_order_relaxed) + 1;
+    m_requested_sequence.store(sequence, std::memory_order_release);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SNAPSHOT_TIMEOUT_MS);
+    while (m_served_sequence.load(std::memory_order_acquire) != sequence && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(SNAPSHOT_POLL_PERIOD);
+    const bool served = m_served_sequence.load(std::memory_order_acquire) == sequence;
+
+    // the snapshot stays untouched until the next request, formatted without holding up the feed task
+    std::string report;
+    if (served)
+    {
+        m_snapshot.read.append_to(report, "read", REPORT_DECIMALS);
+        m_snapshot.period.append_to(report, "period", REPORT_DECIMALS);
+        m_snapshot.jitter.append_to(report, "jitter", REPORT_DECIMALS);
+        m_snapshot.feed.append_to(report, "feed", REPORT_DECIMALS);
+    }
+    else
+    {
+        report += "feed loop not responding\n";
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "overflows: %u, dropped samples: %u\n", static_cast<unsigned>(m_num_overflows),
+             static_cast<unsigned>(m_num_dropped_samples));
+    report += line;
+    return report;
+}
+
+std::string CaptureHealth::get_report()
+{
+    return make_report(false);
+}
+
+std::string CaptureHealth::take_report()
+{
+    return make_report(true);
+}
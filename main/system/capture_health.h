@@ -0,0 +1,70 @@
+#pragma once
+
+#include "latency_probes.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Whether the audio feed loop keeps up with the microphone: histograms of
+// the time spent reading a chunk, of the period between the capture times
+// of successive chunks and its jitter, and of the AFE feed, plus the capture
+// overflows. The feed task owns the histograms and never waits: a report
+// asks it for a copy, which it hands over at the end of its next iteration.
+class CaptureHealth
+{
+public:
+    // Resolution of the histograms, up to 64 ms
+    static constexpr const int64_t BUCKET_US = 250;
+    // How long a report waits for the feed task before it gives up
+    static constexpr const uint32_t SNAPSHOT_TIMEOUT_MS = 500;
+
+    static CaptureHealth &instance();
+
+    // Feed task: reading a chunk returned audio captured at capture_time_us
+    void record_read(int64_t duration_us, int64_t capture_time_us);
+    void record_feed(int64_t duration_us);
+    // Feed task: totals of the input, overflows are the times the capture
+    // ring ran full, and hands the histograms to a waiting report
+    void end_iteration(size_t num_overflows, size_t num_dropped_samples);
+
+    size_t get_num_overflows() const { return m_num_overflows; }
+    size_t get_num_dropped_samples() const { return m_num_dropped_samples; }
+
+    // One line per histogram: count, min, average, p99 and max in ms, then
+    // the overflow totals
+    std::string get_report();
+    // The report, restarting the histograms for the next interval
+    std::string take_report();
+
+private:
+    struct Histograms
+    {
+        LatencyHistogram read{BUCKET_US};
+        LatencyHistogram period{BUCKET_US};
+        LatencyHistogram jitter{BUCKET_US};
+        LatencyHistogram feed{BUCKET_US};
+    };
+
+    std::string make_report(bool restart);
+
+private:
+    // Feed task side
+    Histograms m_histograms;
+    int64_t m_last_capture_time_us = 0;
+    int64_t m_last_period_us = 0;
+
+    // Handover: a report bumps the requested sequence, the feed task copies
+    // into the snapshot and publishes the sequence as served
+    Histograms m_snapshot;
+    std::atomic<uint32_t> m_requested_sequence = 0;
+    std::atomic<uint32_t> m_served_sequence = 0;
+    std::atomic<bool> m_restart_requested = false;
+    // Serializes the reports, the feed task never takes it
+    std::mutex m_report_mutex;
+
+    std::atomic<size_t> m_num_overflows = 0;
+    std::atomic<size_t> m_num_dropped_samples = 0;
+};
@@ -1,4 +1,27 @@
 #include "event_loop.h"
+#include "latency_probes.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "event_loop";
+
+// Retry period of a delayed handler that found the queue full
+constexpr const uint64_t POST_DELAYED_RETRY_US = 10 * 1000;
+
+// Stamped when posted for the queueing delay probe
+struct QueuedHandler
+{
+    Handler handler;
+    int64_t post_time_us = 0;
+};
+
+struct DelayedHandler
+{
+    std::shared_ptr<EventLoop> event_loop;
+    Handler handler;
+    esp_timer_handle_t timer = nullptr;
+};
 
 EventLoop::EventLoop() : m_queue(xQueueCreate(10, sizeof(void *)))
 {
@@ -6,27 +29,70 @@ EventLoop::EventLoop() : m_queue(xQueueCreate(10, sizeof(void *)))
 
 void EventLoop::run()
 {
-    // Report counter value
     while (true)
     {
-        Handler *handler = nullptr;
+        QueuedHandler *handler = nullptr;
         if (xQueueReceive(m_queue, &handler, pdMS_TO_TICKS(1000)))
         {
-            (*handler)();
+            LatencyProbes::instance().record_event_loop(esp_timer_get_time() - handler->post_time_us);
+            handler->handler();
             delete handler;
         }
+        else
+        {
+            // idle for a second, the interaction is over
+            LatencyProbes::instance().log_report_if_updated();
+        }
     }
 }
 
-void EventLoop::post(Handler handler)
+bool EventLoop::post(Handler handler)
 {
-    auto handler_ptr = new Handler(handler);
-    xQueueSend(m_queue, &handler_ptr, 0);
+    auto handler_ptr = new QueuedHandler{.handler = handler, .post_time_us = esp_timer_get_time()};
+    if (xQueueSend(m_queue, &handler_ptr, 0) != pdTRUE)
+    {
+        delete handler_ptr;
+        return false;
+    }
+    return true;
 }
 
 void EventLoop::post_from_isr(Handler handler)
 {
     BaseType_t high_task_wakeup = 0;
-    auto handler_ptr = new Handler(handler);
+    auto handler_ptr = new QueuedHandler{.handler = handler, .post_time_us = esp_timer_get_time()};
     xQueueSendFromISR(m_queue, &handler_ptr, &high_task_wakeup);
-}
\ No newline at end of file
+}
+
+void EventLoop::post_delayed(Handler handler, uint32_t delay_ms)
+{
+    auto context = new DelayedHandler{.event_loop = shared_from_this(), .handler = handler};
+    const esp_timer_create_args_t timer_args = {
+        .callback = post_delayed_handler,
+        .arg = context,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "post_delayed",
+        .skip_unhandled_events = false,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &context->timer));
+    ESP_ERROR_CHECK(esp_timer_start_once(context->timer, static_cast<uint64_t>(delay_ms) * 1000));
+}
+
+void EventLoop::post_delayed_handler(void *arg)
+{
+    // the timer is deleted on the event loop, not from its own callback
+    auto context = reinterpret_cast<DelayedHandler *>(arg);
+    const bool posted = context->event_loop->post(
+        [context]()
+        {
+            esp_timer_delete(context->timer);
+            context->handler();
+            delete context;
+        });
+    if (!posted)
+    {
+        // the timer task must not block on the queue, the one-shot timer has fired and can run again
+        ESP_LOGW(TAG, "Queue full, retrying a delayed handler");
+        ESP_ERROR_CHECK(esp_timer_start_once(context->timer, POST_DELAYED_RETRY_US));
+    }
+}
@@ -13,8 +13,16 @@ public:
     EventLoop();
 
     void run();
-    void post(Handler handler);
+    // False if the queue was full and handler was dropped
+    bool post(Handler handler);
     void post_from_isr(Handler handler);
+    // Posts handler once delay_ms have passed, the caller is not blocked. A
+    // full queue delays the handler, it is never dropped.
+    void post_delayed(Handler handler, uint32_t delay_ms);
+
+private:
+    // Timer callback of post_delayed
+    static void post_delayed_handler(void *arg);
 
 private:
     QueueHandle_t m_queue = nullptr;
@@ -0,0 +1,156 @@
+#include "latency_probes.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <limits>
+
+static const char *TAG = "latency";
+
+static const char *PATH_NAMES[LatencyProbes::NUM_PATHS] = {"wake", "command", "not_recognized"};
+static const char *STAGE_NAMES[LatencyProbes::NUM_STAGES] = {"dispatched", "play_requested", "first_sample"};
+
+void LatencyHistogram::record(int64_t latency_us)
+{
+    latency_us = std::max<int64_t>(latency_us, 0);
+    const size_t bucket = std::min(static_cast<size_t>(latency_us / m_bucket_us), NUM_BUCKETS - 1);
+    if (m_buckets[bucket] < std::numeric_limits<uint16_t>::max())
+        m_buckets[bucket]++;
+
+    m_min_us = m_count == 0 ? latency_us : std::min(m_min_us, latency_us);
+    m_max_us = std::max(m_max_us, latency_us);
+    m_sum_us += latency_us;
+    m_count++;
+}
+
+int64_t LatencyHistogram::get_average_us() const
+{
+    return m_count == 0 ? 0 : m_sum_us / m_count;
+}
+
+int64_t LatencyHistogram::get_percentile_us(uint32_t percent) const
+{
+    uint32_t total = 0;
+    for (const uint16_t count : m_buckets)
+        total += count;
+
+    const uint64_t rank = (static_cast<uint64_t>(total) * percent + 99) / 100;
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < NUM_BUCKETS; i++)
+    {
+        sum += m_buckets[i];
+        if (sum >= rank && sum > 0)
+            return std::min(static_cast<int64_t>(i + 1) * m_bucket_us, m_max_us);
+    }
+    return m_max_us;
+}
+
+void LatencyHistogram::append_to(std::string &report, const char *name, int decimals) const
+{
+    char line[128];
+    snprintf(line, sizeof(line), "%s: n=%" PRIu32 " min=%.*f avg=%.*f p99=%.*f max=%.*f ms\n", name, get_count(),
+             decimals, get_min_us() / 1000.0, decimals, get_average_us() / 1000.0, decimals,
+             get_percentile_us(99) / 1000.0, decimals, get_max_us() / 1000.0);
+    report += line;
+}
+
+LatencyProbes &LatencyProbes::instance()
+{
+    static LatencyProbes probes;
+    return probes;
+}
+
+void LatencyProbes::begin(Path path)
+{
+    const size_t index = static_cast<size_t>(path);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_begin_us[index] = esp_timer_get_time();
+    if (m_armed[index])
+    {
+        // the previous trace never got its sound
+        m_armed[index] = false;
+        m_num_armed--;
+    }
+}
+
+void LatencyProbes::record(Path path, Stage stage, int64_t time_us)
+{
+    const size_t index = static_cast<size_t>(path);
+    m_histograms[index][static_cast<size_t>(stage)].record(time_us - m_begin_us[index]);
+}
+
+void LatencyProbes::mark(Path path, Stage stage)
+{
+    const int64_t time_us = esp_timer_get_time();
+    const size_t index = static_cast<size_t>(path);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_begin_us[index] == 0)
+        return;
+
+    record(path, stage, time_us);
+    if (stage == Stage::PLAY_REQUESTED && !m_armed[index])
+    {
+        m_armed[index] = true;
+        m_num_armed++;
+    }
+}
+
+void LatencyProbes::on_playback_started()
+{
+    // runs on the output task for every playback, untraced ones don't lock
+    if (m_num_armed == 0)
+        return;
+
+    const int64_t time_us = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < NUM_PATHS; i++)
+    {
+        if (!m_armed[i])
+            continue;
+
+        record(static_cast<Path>(i), Stage::FIRST_SAMPLE, time_us);
+        m_armed[i] = false;
+        m_num_armed--;
+        m_begin_us[i] = 0;
+        m_updated = true;
+    }
+}
+
+void LatencyProbes::record_event_loop(int64_t delay_us)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_event_loop_histogram.record(delay_us);
+}
+
+std::string LatencyProbes::get_report() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string report;
+    for (size_t i = 0; i < NUM_PATHS; i++)
+    {
+        for (size_t j = 0; j < NUM_STAGES; j++)
+        {
+            if (m_histograms[i][j].get_count() == 0)
+                continue;
+
+            const std::string name = std::string(PATH_NAMES[i]) + "." + STAGE_NAMES[j];
+            m_histograms[i][j].append_to(report, name.c_str());
+        }
+    }
+    m_event_loop_histogram.append_to(report, "event_loop.queue");
+    return report;
+}
+
+void LatencyProbes::log_report_if_updated()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_updated)
+            return;
+        m_updated = false;
+    }
+    ESP_LOGI(TAG, "Response times since detection:\n%s", get_report().c_str());
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Histogram of latencies in 256 buckets, 2 ms wide by default, longer
+// latencies land in the last bucket. Min, max and average are exact.
+class LatencyHistogram
+{
+public:
+    static constexpr const int64_t DEFAULT_BUCKET_US = 2000;
+    static constexpr const size_t NUM_BUCKETS = 256;
+
+    explicit LatencyHistogram(int64_t bucket_us = DEFAULT_BUCKET_US) : m_bucket_us(bucket_us) {}
+
+    void record(int64_t latency_us);
+
+    uint32_t get_count() const { return m_count; }
+    int64_t get_min_us() const { return m_min_us; }
+    int64_t get_max_us() const { return m_max_us; }
+    int64_t get_average_us() const;
+    // Upper bound of the bucket holding the percentile, max for the last bucket
+    int64_t get_percentile_us(uint32_t percent) const;
+
+    // Appends a line with count, min, average, p99 and max in ms
+    void append_to(std::string &report, const char *name, int decimals = 1) const;
+
+private:
+    int64_t m_bucket_us;
+    std::array<uint16_t, NUM_BUCKETS> m_buckets = {};
+    uint32_t m_count = 0;
+    int64_t m_sum_us = 0;
+    int64_t m_min_us = 0;
+    int64_t m_max_us = 0;
+};
+
+// Response time of the voice interaction paths, from the recognizer's
+// detection to the first sample of the response sound mixed into the
+// output. Every stage keeps a histogram of its time since the detection, and
+// the event loop keeps one of its queueing delay. Probes may be hit from any
+// task.
+class LatencyProbes
+{
+public:
+    enum class Path {
+        WAKE,
+        COMMAND,
+        NOT_RECOGNIZED,
+    };
+
+    enum class Stage {
+        // the event loop started the observer callback
+        DISPATCHED,
+        // the observer requested the response sound
+        PLAY_REQUESTED,
+        // the first sample of the next playback was mixed
+        FIRST_SAMPLE,
+    };
+
+    static constexpr const size_t NUM_PATHS = 3;
+    static constexpr const size_t NUM_STAGES = 3;
+
+    static LatencyProbes &instance();
+
+    // Starts a trace of path at the detection
+    void begin(Path path);
+    // Records the stage of the open trace of path, PLAY_REQUESTED arms FIRST_SAMPLE
+    void mark(Path path, Stage stage);
+    // Called by the output path when a playback mixes its first sample
+    void on_playback_started();
+    void record_event_loop(int64_t delay_us);
+
+    // One line per histogram: count, min, average, p99 and max in ms
+    std::string get_report() const;
+    // Logs the report if a trace completed since the last one
+    void log_report_if_updated();
+
+private:
+    void record(Path path, Stage stage, int64_t time_us);
+
+private:
+    mutable std::mutex m_mutex;
+    std::array<int64_t, NUM_PATHS> m_begin_us = {};
+    std::array<bool, NUM_PATHS> m_armed = {};
+    std::atomic<uint32_t> m_num_armed = 0;
+    std::array<std::array<LatencyHistogram, NUM_STAGES>, NUM_PATHS> m_histograms;
+    LatencyHistogram m_event_loop_histogram;
+    bool m_updated = false;
+};
@@ -2,35 +2,55 @@
 
 #include "hal/file_system.h"
 #include "nossat_err.h"
-#include "sound/audio_data.h"
+#include "sound/audio_view.h"
+#include "sound/prompt_pack.h"
+#include "sound/read_stream.h"
+#include "sound/wav_stream.h"
 
-#include <vector>
+#include <cstdio>
+#include <memory>
 
 struct ResourceManager
 {
-    const char *WAKE_WAV_PATH = "/spiffs/echo_en_wake.wav";
-    const char *RECOGNIZED_WAV_PATH = "/spiffs/echo_en_recognized.wav";
-    const char *NOT_RECOGNIZED_WAV_PATH = "/spiffs/echo_en_not_recognized.wav";
+    // Built from prompts/ by tools/build_prompts.py into the SPIFFS image, in
+    // the output format and with the prompt gain applied
+    const char *PROMPT_PACK_PATH = "/spiffs/prompts.bin";
 
-    ResourceManager()
+    const char *WAKE_PROMPT = "wake";
+    const char *RECOGNIZED_PROMPT = "recognized";
+    const char *NOT_RECOGNIZED_PROMPT = "not_recognized";
+
+    // The wake prompt is resident so it starts without touching flash, the
+    // longer prompts are streamed
+    explicit ResourceManager(const AudioFormat &output_format) : m_output_format(output_format)
+    {
+        FILE *fp = fopen(PROMPT_PACK_PATH, "rb");
+        ESP_TRUE_CHECK(fp != nullptr);
+        FileReadStream stream(fp, true);
+        ESP_TRUE_CHECK(m_prompt_pack.load(stream, output_format));
+
+        const PromptPack::Prompt *wake = m_prompt_pack.find(WAKE_PROMPT);
+        ESP_TRUE_CHECK(wake != nullptr && !wake->audio.is_empty());
+        wake_wav = wake->audio;
+    }
+
+    // Opens a prompt of the pack for streaming playback, the file system stays mounted for it
+    std::unique_ptr<WavStream> open_stream(const char *name) const
     {
-        FileSystem file_system;
-        std::vector<int8_t> buffer;
-
-        const auto load_resource_wav = [&buffer, &file_system](const char *name)
-        {
-            ESP_TRUE_CHECK(file_system.load_file(name, buffer));
-            auto audio = AudioData::load_wav(buffer);
-            audio.adjust_volume(0.05);
-            return audio;
-        };
-
-        wake_wav = load_resource_wav(WAKE_WAV_PATH);
-        recognized_wav = load_resource_wav(RECOGNIZED_WAV_PATH);
-        not_recognized_wav = load_resource_wav(NOT_RECOGNIZED_WAV_PATH);
+        const PromptPack::Prompt *prompt = m_prompt_pack.find(name);
+        ESP_TRUE_CHECK(prompt != nullptr);
+        FILE *fp = fopen(PROMPT_PACK_PATH, "rb");
+        ESP_TRUE_CHECK(fp != nullptr);
+        ESP_TRUE_CHECK(fseek(fp, prompt->wav_offset, SEEK_SET) == 0);
+        auto stream = std::make_unique<WavStream>(std::make_unique<FileReadStream>(fp, true), m_output_format);
+        ESP_TRUE_CHECK(stream->open());
+        return stream;
     }
 
-    AudioData wake_wav;
-    AudioData recognized_wav;
-    AudioData not_recognized_wav;
+    ConstAudioView wake_wav;
+
+private:
+    FileSystem m_file_system;
+    const AudioFormat m_output_format;
+    PromptPack m_prompt_pack;
 };
\ No newline at end of file
@@ -15,10 +15,14 @@ void create_task(Proc proc, const char *name, uint32_t stack_depth, int priority
     TaskHandle_t handle;
     TaskFunction_t adapter = [](void *param)
     {
-        auto context = reinterpret_cast<TaskContext *>(param);
-        Proc proc = context->proc;
-        delete context;
-        proc();
+        // vTaskDelete() never returns, the captures of a task that ends are
+        // released before it
+        {
+            auto context = reinterpret_cast<TaskContext *>(param);
+            Proc proc = std::move(context->proc);
+            delete context;
+            proc();
+        }
         vTaskDelete(NULL);
     };
 
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Local stand-in for the Home Assistant TTS endpoint.
+
+Serves the WAV files of a directory paced like a network stream, to try the
+device's streaming playback and jitter buffer without Home Assistant:
+
+    tools/audio_stream_server.py --directory prompts --stall-every 2 --stall-ms 300
+    mosquitto_pub -t nossat_one/play -m http://<host>:8000/echo_en_recognized.wav
+
+The body is sent in packets at --speed times real time, with an optional stall
+every --stall-every seconds of audio. PCM and IMA ADPCM files are served as is.
+"""
+
+import argparse
+import functools
+import http.server
+import os
+import struct
+import time
+
+PACKET_MS = 20
+
+
+def get_byte_rate(data):
+    """Bytes per second of a RIFF/WAVE file, from its fmt chunk."""
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError("not a RIFF/WAVE file")
+    position = 12
+    while position + 8 <= len(data):
+        chunk_id, size = struct.unpack_from("<4sI", data, position)
+        if chunk_id == b"fmt ":
+            return struct.unpack_from("<I", data, position + 16)[0]
+        position += 8 + size + (size & 1)
+    raise ValueError("no fmt chunk")
+
+
+class StreamHandler(http.server.SimpleHTTPRequestHandler):
+    def __init__(self, *args, options, **kwargs):
+        self.options = options
+        super().__init__(*args, **kwargs)
+
+    def do_GET(self):
+        path = self.translate_path(self.path)
+        if not path.endswith(".wav") or not os.path.isfile(path):
+            self.send_error(404)
+            return
+
+        with open(path, "rb") as file:
+            data = file.read()
+        try:
+            byte_rate = get_byte_rate(data)
+        except ValueError as error:
+            self.send_error(415, str(error))
+            return
+
+        self.send_response(200)
+        self.send_header("Content-Type", "audio/wav")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+
+        packet_size = max(1, byte_rate * PACKET_MS // 1000)
+        stall_bytes = byte_rate * self.options.stall_every
+        next_stall = stall_bytes
+        start = time.monotonic()
+        for offset in range(0, len(data), packet_size):
+            if self.options.stall_every and offset >= next_stall:
+                time.sleep(self.options.stall_ms / 1000)
+                start += self.options.stall_ms / 1000
+                next_stall += stall_bytes
+            # paced against the start so the sleep granularity doesn't add up
+            delay = start + offset / byte_rate / self.options.speed - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            self.wfile.write(data[offset : offset + packet_size])
+            self.wfile.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--directory", default=".", help="directory of the WAV files")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--speed", type=float, default=1.5, help="send rate relative to real time")
+    parser.add_argument("--stall-every", type=float, default=0, help="seconds of audio between stalls, 0 for none")
+    parser.add_argument("--stall-ms", type=float, default=200, help="length of a stall")
+    options = parser.parse_args()
+
+    handler = functools.partial(StreamHandler, directory=options.directory, options=options)
+    server = http.server.ThreadingHTTPServer(("", options.port), handler)
+    print(f"Serving {options.directory} on port {options.port}")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Builds the prompt pack of the SPIFFS image.
+
+Every prompt is converted to the device output format with the gain applied,
+so the device loads it without any per-sample processing:
+
+    tools/build_prompts.py --directory prompts --output build/spiffs/prompts.bin \\
+        --sample-rate 16000 --channels 2 --gain 0.05 wake=echo_en_wake.wav
+
+The pack starts with a header and an index of the prompts, followed by every
+prompt as a canonical 16-bit PCM WAV. Prompts up to --max-resident-ms come
+first, the device reads them together with the index in one go and plays them
+from memory; longer ones are streamed. The layout is read by
+main/sound/prompt_pack.cpp.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+MAGIC = b"NPRM"
+VERSION = 1
+MAX_NAME_SIZE = 16
+PROMPT_RESIDENT = 0x1
+
+HEADER = struct.Struct("<4sHHIHHI")
+ENTRY = struct.Struct(f"<{MAX_NAME_SIZE}sIIII")
+WAV_HEADER_SIZE = 44
+
+WAVE_FORMAT_PCM = 0x0001
+WAVE_FORMAT_IEEE_FLOAT = 0x0003
+WAVE_FORMAT_EXTENSIBLE = 0xFFFE
+
+# Windowed sinc taps on each side of the interpolated sample
+RESAMPLE_HALF_TAPS = 16
+
+
+def read_wav(path):
+    """Returns (sample_rate, channels) of a PCM or float WAV, samples as floats in [-1, 1)."""
+    with open(path, "rb") as file:
+        data = file.read()
+    if data[0:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError(f"{path}: not a RIFF/WAVE file")
+
+    fmt = None
+    position = 12
+    while position + 8 <= len(data):
+        chunk_id, size = struct.unpack_from("<4sI", data, position)
+        body = data[position + 8 : position + 8 + size]
+        if chunk_id == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body)
+            if fmt[0] == WAVE_FORMAT_EXTENSIBLE and size >= 26:
+                fmt = (struct.unpack_from("<H", body, 24)[0],) + fmt[1:]
+        elif chunk_id == b"data":
+            break
+        position += 8 + size + (size & 1)
+    else:
+        raise ValueError(f"{path}: no data chunk")
+    if fmt is None:
+        raise ValueError(f"{path}: no fmt chunk")
+
+    audio_format, num_channels, sample_rate, _, _, bits = fmt
+    width = bits // 8
+    if audio_format == WAVE_FORMAT_IEEE_FLOAT and bits == 32:
+        values = [v for (v,) in struct.iter_unpack("<f", body[: len(body) // 4 * 4])]
+    elif audio_format == WAVE_FORMAT_PCM and bits == 8:
+        values = [(b - 128) / 128 for b in body]
+    elif audio_format == WAVE_FORMAT_PCM and bits in (16, 24, 32):
+        scale = 1 << (bits - 1)
+        values = [
+            int.from_bytes(body[i : i + width], "little", signed=True) / scale
+            for i in range(0, len(body) // width * width, width)
+        ]
+    else:
+        raise ValueError(f"{path}: unsupported format {audio_format} with {bits} bits, convert it to PCM")
+
+    num_samples = len(values) // num_channels
+    channels = [values[c : num_samples * num_channels : num_channels] for c in range(num_channels)]
+    return sample_rate, channels
+
+
+def map_channels(channels, num_channels):
+    """Same mapping as convert_audio() on the device."""
+    if len(channels) == num_channels:
+        return channels
+    if len(channels) == 1:
+        return [channels[0]] * num_channels
+    if num_channels == 1:
+        return [[sum(values) / len(values) for values in zip(*channels)]]
+    return [channels[c % len(channels)] for c in range(num_channels)]
+
+
+def resample(values, input_rate, output_rate):
+    if input_rate == output_rate:
+        return values
+    ratio = output_rate / input_rate
+    # the cutoff follows the lower of both rates
+    cutoff = min(1.0, ratio)
+    num_output = int(len(values) * ratio)
+    output = []
+    for i in range(num_output):
+        center = i / ratio
+        first = math.floor(center) - RESAMPLE_HALF_TAPS + 1
+        total = 0.0
+        for j in range(first, first + 2 * RESAMPLE_HALF_TAPS):
+            if 0 <= j < len(values):
+                x = center - j
+                window = 0.5 + 0.5 * math.cos(math.pi * x / RESAMPLE_HALF_TAPS)
+                arg = math.pi * x * cutoff
+                sinc = 1.0 if arg == 0 else math.sin(arg) / arg
+                total += values[j] * sinc * cutoff * window
+        output.append(total)
+    return output
+
+
+def to_pcm16(channels, gain):
+    num_samples = min(len(values) for values in channels)
+    pcm = bytearray()
+    for i in range(num_samples):
+        for values in channels:
+            value = round(values[i] * gain * 32768)
+            pcm += struct.pack("<h", max(-32768, min(32767, value)))
+    return bytes(pcm), num_samples
+
+
+def make_wav(pcm, sample_rate, num_channels):
+    block_align = num_channels * 2
+    header = b"RIFF" + struct.pack("<I", 36 + len(pcm)) + b"WAVE"
+    header += b"fmt " + struct.pack("<IHHIIHH", 16, WAVE_FORMAT_PCM, num_channels, sample_rate,
+                                    sample_rate * block_align, block_align, 16)
+    header += b"data" + struct.pack("<I", len(pcm))
+    assert len(header) == WAV_HEADER_SIZE
+    # chunks are padded to an even size, 16-bit data always is
+    return header + pcm
+
+
+def align(value, alignment=4):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def build_pack(prompts, sample_rate, num_channels, max_resident_samples):
+    """prompts is a list of (name, pcm, num_samples)."""
+    # resident prompts first, so they are read with the index
+    ordered = sorted(prompts, key=lambda prompt: prompt[2] > max_resident_samples)
+
+    offset = HEADER.size + ENTRY.size * len(prompts)
+    entries = []
+    wavs = bytearray()
+    resident_size = offset
+    for name, pcm, num_samples in ordered:
+        padding = align(offset) - offset
+        wavs += bytes(padding)
+        offset += padding
+        resident = num_samples <= max_resident_samples
+        entries.append(ENTRY.pack(name.encode(), offset, offset + WAV_HEADER_SIZE, num_samples,
+                                  PROMPT_RESIDENT if resident else 0))
+        wav = make_wav(pcm, sample_rate, num_channels)
+        wavs += wav
+        offset += len(wav)
+        if resident:
+            resident_size = offset
+
+    header = HEADER.pack(MAGIC, VERSION, len(prompts), sample_rate, num_channels, 16, resident_size)
+    return header + b"".join(entries) + bytes(wavs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("prompts", nargs="+", metavar="NAME=FILE", help="prompt name and its source WAV")
+    parser.add_argument("--directory", default=".", help="directory of the source WAVs")
+    parser.add_argument("--output", required=True)
+    parser.add_argument("--sample-rate", type=int, default=16000)
+    parser.add_argument("--channels", type=int, default=2)
+    parser.add_argument("--gain", type=float, default=1.0, help="linear gain applied to every prompt")
+    parser.add_argument("--max-resident-ms", type=int, default=1000)
+    options = parser.parse_args()
+
+    prompts = []
+    for argument in options.prompts:
+        name, separator, file_name = argument.partition("=")
+        if not separator or not name:
+            parser.error(f"{argument}: expected NAME=FILE")
+        if len(name.encode()) >= MAX_NAME_SIZE:
+            parser.error(f"{name}: names are limited to {MAX_NAME_SIZE - 1} bytes")
+
+        try:
+            input_rate, channels = read_wav(os.path.join(options.directory, file_name))
+        except (OSError, ValueError) as error:
+            sys.exit(f"build_prompts: {error}")
+        channels = [resample(values, input_rate, options.sample_rate) for values in channels]
+        channels = map_channels(channels, options.channels)
+        pcm, num_samples = to_pcm16(channels, options.gain)
+        prompts.append((name, pcm, num_samples))
+
+    max_resident_samples = options.sample_rate * options.max_resident_ms // 1000
+    pack = build_pack(prompts, options.sample_rate, options.channels, max_resident_samples)
+
+    os.makedirs(os.path.dirname(os.path.abspath(options.output)), exist_ok=True)
+    with open(options.output, "wb") as file:
+        file.write(pack)
+    print(f"build_prompts: {len(prompts)} prompts, {len(pack)} bytes")
+
+
+if __name__ == "__main__":
+    main()